@@ -28,8 +28,13 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <inttypes.h>
 
+#include <pacman/utils.hpp>
+
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_mixer.h>
 #include <SDL2/SDL_timer.h>
@@ -68,6 +73,13 @@ class audio_sample_t {
          */
         audio_sample_t(const std::string &fname, const bool single_play, const int volume=MIX_MAX_VOLUME/2);
 
+        /**
+         * Create a new instance owning the given already decoded chunk, see audio_loader_t.
+         * @param chunk_ decoded chunk, may be nullptr if loading failed, logged by the caller
+         * @param volume value from 0 to MIX_MAX_VOLUME
+         */
+        audio_sample_t(Mix_Chunk* chunk_, const bool single_play, const int volume=MIX_MAX_VOLUME/2);
+
         /**
          * Create an instance for single play use, see set_single_play().
          * @param fname
@@ -101,6 +113,134 @@ class audio_sample_t {
         void set_single_play(bool enable) { singly = enable; }
 
         bool is_valid() const { return nullptr != chunk.get(); }
+
+        bool is_single_play() const { return singly; }
+};
+
+/**
+ * Decodes a set of audio clips on worker threads,
+ * allowing the caller to initialize video and textures meanwhile.
+ * The decoder calls are serialized, while cached clips are read in parallel.
+ *
+ * Must be created after audio_open(), since clips are decoded to the opened mixer format.
+ *
+ * If a cache directory is given, the decoded PCM of each clip is stored there
+ * and used by later launches as long as the source file size and modification time
+ * as well as the mixer format are unchanged, skipping the decoder altogether.
+ */
+class audio_loader_t {
+    public:
+        struct clip_t {
+            std::string fname;
+            bool single_play;
+        };
+
+    private:
+        std::vector<clip_t> clips;
+        std::string cache_dir;
+        std::vector<Mix_Chunk*> chunks;
+        /** SDL error per failed clip, captured on its worker as SDL_GetError() is thread local */
+        std::vector<std::string> errors;
+        std::atomic_size_t next_clip;
+        std::vector<std::thread> workers;
+        uint64_t t0;
+
+        void run() noexcept;
+        Mix_Chunk* load(const clip_t& clip, std::string& error) noexcept;
+        void join() noexcept;
+
+    public:
+        /**
+         * Starts decoding the given clips.
+         * @param clips_ the clips to decode
+         * @param cache_dir_ directory of the decoded PCM cache, pass an empty string to disable the cache
+         */
+        audio_loader_t(std::vector<clip_t> clips_, const std::string& cache_dir_);
+
+        /** Waits for all workers and releases all chunks not taken. */
+        ~audio_loader_t() noexcept;
+
+        audio_loader_t(const audio_loader_t&) = delete;
+        audio_loader_t& operator=(const audio_loader_t&) = delete;
+
+        /**
+         * Waits for all clips being decoded and appends them in the given order to dest.
+         *
+         * Failed clips are appended as invalid audio_sample_t.
+         */
+        void take(std::vector<std::shared_ptr<audio_sample_t>>& dest) noexcept;
+};
+
+/**
+ * Plays and stops audio samples on a dedicated audio thread,
+ * fed by a lock-free spsc_ring_t of commands from the single game (producer) thread.
+ *
+ * The producer never enters SDL_mixer, hence never blocks on the audio device lock.
+ * It skips commands redundant to the last one posted for the same sample,
+ * i.e. a repeated stop or a repeated play of a single play sample looping infinitely.
+ *
+ * The audio thread drains all pending commands at once and coalesces them per sample
+ * into at most one stop followed by the plays posted after it, one for a single play sample.
+ * The result equals applying all commands in order, see audio_sample_t::play() and audio_sample_t::stop().
+ */
+class audio_queue_t {
+    public:
+        struct command_t {
+            /** index into the samples */
+            int sample;
+            /** loops passed to audio_sample_t::play(), or -1 to stop */
+            int loops;
+        };
+
+    private:
+        static constexpr const int stop_cmd = -1;
+
+        std::vector<std::shared_ptr<audio_sample_t>>& samples;
+        spsc_ring_t<command_t, 256> ring;
+        /** producer owned last command posted per sample */
+        std::vector<int> last_posted;
+        /** consumer owned per sample state while draining: stop requested and the plays posted after it */
+        struct pending_t {
+            bool stop = false;
+            std::vector<int> plays;
+        };
+        std::vector<pending_t> pending;
+        std::atomic<bool> running;
+        std::mutex mtx_wakeup;
+        std::condition_variable cv_wakeup;
+        std::thread worker;
+
+        void post(const command_t& c) noexcept;
+        void run() noexcept;
+        void drain() noexcept;
+
+    public:
+        /**
+         * Starts the audio thread.
+         * @param samples_ the samples to play, must not be modified until stop()
+         */
+        audio_queue_t(std::vector<std::shared_ptr<audio_sample_t>>& samples_);
+
+        ~audio_queue_t() noexcept { stop(); }
+
+        audio_queue_t(const audio_queue_t&) = delete;
+        audio_queue_t& operator=(const audio_queue_t&) = delete;
+
+        /**
+         * Producer: Requests playing the given sample.
+         * @param sample index into the samples
+         * @param loops pass 0 for infinity, otherwise the number of loops, see audio_sample_t::play()
+         */
+        void play(const int sample, const int loops=1) noexcept { post( command_t { sample, loops } ); }
+
+        /**
+         * Producer: Requests stopping the given sample.
+         * @param sample index into the samples
+         */
+        void stop(const int sample) noexcept { post( command_t { sample, stop_cmd } ); }
+
+        /** Applies all pending commands and stops the audio thread. */
+        void stop() noexcept;
 };
 
 #endif /* PACMAN_AUDIO_HPP_ */
@@ -74,7 +74,7 @@ struct ghost_wave_t {
 };
 typedef std::vector<ghost_wave_t> ghost_wave_vec_t;
 
-// ghost_t::ghost_count size - one for each
+// ghost_t::personality_count size - one for each
 typedef std::vector<int> ghost_pellet_counter_limit_t;
 
 extern ghost_pellet_counter_limit_t global_ghost_pellet_counter_limit;
@@ -107,6 +107,20 @@ struct game_level_spec_t {
 const game_level_spec_t& game_level_spec(const int level) noexcept;
 const game_level_spec_t& game_level_spec() noexcept;
 
+/**
+ * Loads a level specification file, e.g. `media/level_spec.txt`, into dest.
+ *
+ * Each `level` line specifies one game_level_spec_t in column order,
+ * referring to the ghost waves and pellet counter limits declared via preceding `wave` and `limit` lines by name.
+ * Empty lines and lines starting with `#` are ignored.
+ *
+ * @return true if successful and at least one level has been specified, otherwise dest is left untouched.
+ */
+bool load_level_spec(const std::string& fname, std::vector<game_level_spec_t>& dest) noexcept;
+
+/** Replaces the current level specification, see load_level_spec(). Not thread safe. */
+void set_level_spec(std::vector<game_level_spec_t>&& spec) noexcept;
+
 const ghost_wave_t& get_ghost_wave(const int level, const int phase_idx) noexcept;
 const ghost_wave_t& get_ghost_wave(const int phase_idx) noexcept;
 
@@ -117,7 +131,7 @@ const ghost_wave_t& get_ghost_wave(const int phase_idx) noexcept;
 class global_tex_t {
     private:
         std::shared_ptr<texture_t> all_images_;
-        std::vector<std::shared_ptr<texture_t>> textures;
+        std::vector<tex_handle_t> textures;
         animtex_t atex_pellet_power;
 
         /**
@@ -151,22 +165,60 @@ class global_tex_t {
 
         std::shared_ptr<texture_t> all_images() noexcept { return all_images_; }
 
-        std::shared_ptr<texture_t> texture(const tile_t tile) noexcept;
-        std::shared_ptr<const texture_t> texture(const tile_t tile) const noexcept;
+        tex_handle_t handle(const tile_t tile) const noexcept;
+        tex_handle_t handle(const int idx) const noexcept;
 
-        std::shared_ptr<texture_t> texture(const int idx) noexcept;
-        std::shared_ptr<const texture_t> texture(const int idx) const noexcept;
+        tex_region_t texture(const tile_t tile) const noexcept { return get_tex_region( handle(tile) ); }
+        tex_region_t texture(const int idx) const noexcept { return get_tex_region( handle(idx) ); }
 
         bool tick() noexcept {
             atex_pellet_power.tick();
             return true;
         }
 
-        void draw_tile(const tile_t tile, SDL_Renderer* rend, const float x, const float y) noexcept;
+        /** Returns the current animation texture handle of the power pellets. */
+        tex_handle_t pellet_power_texture() const noexcept { return atex_pellet_power.handle(); }
+
+        /**
+         * Draws the given tile.
+         * @param pellet_power_tex the power pellet texture handle captured via pellet_power_texture()
+         */
+        void draw_tile(const tile_t tile, SDL_Renderer* rend, const float x, const float y, const tex_handle_t pellet_power_tex) const noexcept;
 
         std::string toString() const;
 };
 
+//
+// actor_pos_t
+//
+
+/**
+ * Actor center position in tiles of the current and previous simulation tick,
+ * allowing the renderer to interpolate in between.
+ */
+struct actor_pos_t {
+    float x, y;
+    float prev_x, prev_y;
+
+    /**
+     * Returns the interpolated position.
+     *
+     * The current position is returned if the actor moved more than one tile,
+     * e.g. wrapped through the tunnel or was reset to its start position.
+     *
+     * @param alpha fraction [0..1] of the tick period elapsed since the current tick
+     */
+    void interpolate(const float alpha, float& x_, float& y_) const noexcept {
+        if( std::abs( x - prev_x ) <= 1.0f && std::abs( y - prev_y ) <= 1.0f ) {
+            x_ = prev_x + ( x - prev_x ) * alpha;
+            y_ = prev_y + ( y - prev_y ) * alpha;
+        } else {
+            x_ = x;
+            y_ = y;
+        }
+    }
+};
+
 //
 // ghost_t
 //
@@ -189,7 +241,59 @@ class ghost_t {
         static constexpr int number(const personality_t item) noexcept {
             return static_cast<int>(item);
         }
-        static constexpr const int ghost_count = 4;
+        /** Number of personality_t, i.e. the default ghost count */
+        static constexpr const int personality_count = 4;
+        /** Maximum ghost count, see `-ghosts` */
+        static constexpr const int max_ghost_count = 256;
+
+        /** CHASE mode target rule of traits_t */
+        enum class target_rule_t : int {
+            /** Pac-Man's position, Blinky */
+            PACMAN,
+            /** Four tiles ahead of Pac-Man, Pinky */
+            AHEAD,
+            /** Blinky's vector to two tiles ahead of Pac-Man doubled, Inky */
+            MIRROR_BLINKY,
+            /** Pac-Man's position if farther than eight tiles, otherwise the scatter corner, Clyde */
+            SHY
+        };
+
+        /** SCATTER mode corner of traits_t, see maze_t scatter positions */
+        enum class corner_t : int {
+            TOP_LEFT,
+            TOP_RIGHT,
+            BOTTOM_LEFT,
+            BOTTOM_RIGHT
+        };
+
+        /**
+         * Data driven personality of a ghost, see traits_of().
+         */
+        struct traits_t {
+            /** texture and color */
+            personality_t look;
+            target_rule_t chase_rule;
+            corner_t scatter_corner;
+            /** index of game_level_spec_t::ghost_pellet_counter_limit and global_ghost_pellet_counter_limit */
+            int pellet_limit_idx;
+            /** added to the pellet counter limit, delaying the release of additional ghosts */
+            int pellet_limit_extra;
+            /** home position x offset from the ghost house center */
+            float home_dx;
+            /** true if starting outside of the ghost house and never held by a pellet counter, Blinky */
+            bool start_outside;
+            /** true if speeding up with few pellets left, Blinky as Cruise Elroy */
+            bool elroy;
+        };
+
+        /**
+         * Returns the traits of the ghost at the given index within ghosts(),
+         * cycling through the four original personalities.
+         *
+         * Each further group of four ghosts waits extra_pellet_limit more pellets at home.
+         */
+        static traits_t traits_of(const int index) noexcept;
+        static constexpr const int extra_pellet_limit = 10;
 
         enum class mode_t {
             PACMAN_DIED,
@@ -207,6 +311,26 @@ class ghost_t {
         /** RGB color of the ghosts in number(personality_t) order. */
         static std::vector<std::vector<int>> rgb_color;
 
+        /**
+         * Immutable render state captured by the simulation thread after tick(),
+         * see frame_snapshot_t.
+         */
+        struct snapshot_t {
+            personality_t id;
+            /** false if away or hidden within pacman's freeze box */
+            bool visible;
+            /** true if scattering or chasing, i.e. target is valid */
+            bool has_target;
+            /** current animation texture */
+            tex_handle_t tex;
+            /** center position in tiles */
+            actor_pos_t pos;
+            /** keyframei_t::center() */
+            float center;
+            /** target position in tiles */
+            float target_x, target_y;
+        };
+
     private:
         static random_engine_t<random_engine_mode_t::STD_RNG> rng_hw;
         static random_engine_t<random_engine_mode_t::STD_PRNG_0> rng_prng;
@@ -228,6 +352,9 @@ class ghost_t {
         countdown_t sync_next_frame_cntr;
 
         personality_t id_;
+        /** index within ghosts() */
+        int index_;
+        traits_t traits_;
         int live_counter_during_pacman_live;
         mode_t mode_;
         mode_t mode_last;
@@ -238,6 +365,7 @@ class ghost_t {
         static bool global_pellet_counter_active;
         static int global_pellet_counter;
         static int global_pellet_time_left;
+        static occupancy_grid_t occupancy_;
 
         animtex_t atex_normal;
         animtex_t atex_scared;
@@ -257,6 +385,9 @@ class ghost_t {
 
         static int id_to_yoff(ghost_t::personality_t id) noexcept;
 
+        /** Indexes pos_ in the occupancy() grid, called whenever pos_ changes. */
+        void update_occupancy() noexcept;
+
         animtex_t& get_tex() noexcept;
 
         constexpr animtex_t& get_phantom_tex() noexcept { return atex_phantom; }
@@ -286,18 +417,30 @@ class ghost_t {
         /** Return true if speed changed, otherwise false */
         bool set_mode_speed() noexcept;
         void tick() noexcept;
-        void draw(SDL_Renderer* rend) noexcept;
+        snapshot_t get_snapshot() const noexcept;
+        static void draw(SDL_Renderer* rend, const snapshot_t& s, const float alpha) noexcept;
 
     public:
-        ghost_t(const personality_t id_, SDL_Renderer* rend, const float fields_per_sec_total_) noexcept;
+        /**
+         * @param index__ index within ghosts(), determining its traits_of()
+         */
+        ghost_t(const int index__, SDL_Renderer* rend, const float fields_per_sec_total_) noexcept;
 
         ~ghost_t() noexcept {
             destroy();
         }
 
+        /** Owning its animation textures, a ghost_t is neither copyable nor movable, see ghosts(). */
+        ghost_t(const ghost_t&) = delete;
+        ghost_t(ghost_t&&) = delete;
+        ghost_t& operator=(const ghost_t&) = delete;
+        ghost_t& operator=(ghost_t&&) = delete;
+
         void destroy() noexcept;
 
         constexpr personality_t id() const noexcept { return id_; }
+        constexpr int index() const noexcept { return index_; }
+        constexpr const traits_t& traits() const noexcept { return traits_; }
 
         constexpr const keyframei_t& keyframei() const noexcept { return keyframei_; }
 
@@ -328,7 +471,17 @@ class ghost_t {
         /** For global SCATTER, CHASE or SCARED mode switch, etc. */
         static void global_tick() noexcept;
 
-        static void global_draw(SDL_Renderer* rend) noexcept;
+        /** Captures all ghosts' snapshot_t into dest, reusing its capacity. */
+        static void global_snapshot(std::vector<snapshot_t>& dest) noexcept;
+
+        /** Returns the per tile occupancy of all ghosts, actor number being index(). */
+        static const occupancy_grid_t& occupancy() noexcept { return occupancy_; }
+
+        /**
+         * Draws the given snapshots.
+         * @param alpha interpolation fraction, see actor_pos_t::interpolate()
+         */
+        static void global_draw(SDL_Renderer* rend, const std::vector<snapshot_t>& snapshots, const float alpha) noexcept;
 
         static std::string pellet_counter_string() noexcept;
         static void notify_pellet_eaten() noexcept;
@@ -369,8 +522,25 @@ class pacman_t {
         /** RGB color of pacman . */
         static std::vector<int> rgb_color;
 
+        /**
+         * Immutable render state captured by the simulation thread after tick(),
+         * see frame_snapshot_t.
+         */
+        struct snapshot_t {
+            /** current animation texture */
+            tex_handle_t tex;
+            /** center position in tiles */
+            actor_pos_t pos;
+            /** keyframei_t::center() */
+            float center;
+            /** true if in freeze mode, showing freeze_score if >= 0 instead of tex */
+            bool freeze;
+            int freeze_score;
+        };
+
     private:
-        static random_engine_t<random_engine_mode_t::STD_RNG> rng_hw;
+        /** Predictable PRNG for the fruit duration, allowing to replay a recorded input log */
+        static random_engine_t<random_engine_mode_t::STD_PRNG_0> rng_fruit;
         const int ms_per_tex = 167;
 
         /**
@@ -405,6 +575,8 @@ class pacman_t {
         int freeze_score;
         box_t freeze_box_;
         int freeze_frame_count;
+        /** Reused ghost indices of the collision test, see ghost_t::occupancy() */
+        std::vector<int> collision_candidates;
 
         animtex_t atex_left;
         animtex_t atex_right;
@@ -417,7 +589,8 @@ class pacman_t {
         acoord_t pos_;
 
         uint64_t perf_fields_walked_t0 = 0;
-        uint64_t perf_frame_count_walked = 0;
+        /** simulation ticks since reset_stats(), owned by the simulation thread */
+        uint64_t perf_tick_count_walked = 0;
 
         animtex_t& get_tex() noexcept;
 
@@ -441,6 +614,16 @@ class pacman_t {
         const box_t& freeze_box() const noexcept { return freeze_box_; }
 
         void reset_score() noexcept { score_ = 0; }
+
+        /** Sets the score, restoring a level restart of a replay. */
+        void set_score(const uint64_t v) noexcept { score_ = v; }
+
+        /** Returns the fruit duration PRNG state, see random_engine_t::state(). */
+        static uint32_t fruit_rng_state() noexcept { return (uint32_t)rng_fruit.state(); }
+
+        /** Continues the fruit duration PRNG at the given state, restoring a level restart of a replay. */
+        static void set_fruit_rng_state(const uint32_t v) noexcept { rng_fruit.seed(v); }
+
         void set_mode(const mode_t m, const int mode_ms=-1) noexcept;
         void stop_audio_loops() noexcept;
         void set_speed(const float pct) noexcept;
@@ -462,13 +645,51 @@ class pacman_t {
          */
         bool tick() noexcept;
 
-        void draw(SDL_Renderer* rend) noexcept;
+        snapshot_t get_snapshot() const noexcept;
+
+        /**
+         * Draws the given snapshot.
+         * @param alpha interpolation fraction, see actor_pos_t::interpolate()
+         */
+        static void draw(SDL_Renderer* rend, const snapshot_t& s, const float alpha) noexcept;
 
         std::string toString() const noexcept;
 };
 
 std::string to_string(pacman_t::mode_t m);
 
+//
+// frame_snapshot_t
+//
+
+/**
+ * Immutable game state of one simulation tick,
+ * produced by the simulation thread and consumed by the render thread via triple_buffer_t.
+ *
+ * Recycled instances keep their container capacity, i.e. refilling does not allocate.
+ * Only the nonempty maze tiles are copied, see maze_t::for_each_nonempty_tile(),
+ * and only if maze_t::modcount() differs from tiles_modcount.
+ * The immutable walls are drawn from the original maze.
+ */
+struct frame_snapshot_t {
+    /** simulation tick counter, zero if not yet filled */
+    uint64_t tick = 0;
+    /** monotonic time of the tick in nanoseconds */
+    int64_t tick_ns = 0;
+    int level = 0;
+    uint64_t score = 0;
+    /** true if the READY! message shall be shown */
+    bool show_ready = false;
+    int pellets_left = 0;
+    int pellets_max = 0;
+    /** current animation texture of the power pellets */
+    tex_handle_t pellet_power_tex = tex_handle_none;
+    uint64_t tiles_modcount = 0;
+    std::vector<tile_pos_t> tiles;
+    pacman_t::snapshot_t pacman = {};
+    std::vector<ghost_t::snapshot_t> ghosts;
+};
+
 //
 // globals for game
 //
@@ -480,13 +701,17 @@ extern std::unique_ptr<maze_t> global_maze;
 
 extern std::shared_ptr<global_tex_t> global_tex;
 
-typedef std::shared_ptr<ghost_t> ghost_ref;
+typedef ghost_t* ghost_ref;
 /**
- * ghosts are in proper ghost_t enum order for array access,
- * i.e. BLINKY, PINKY, INKY and CLYDE.
+ * ghosts are stored contiguously in index order, see ghost_t::traits_of(),
+ * the first four being BLINKY, PINKY, INKY and CLYDE.
+ *
+ * The storage is allocated once at startup for the `-ghosts` count, each ghost_t constructed in place,
+ * since ghost_t owns its animation textures and is neither copyable nor movable.
  */
-std::vector<ghost_ref>& ghosts() noexcept;
+inplace_array_t<ghost_t>& ghosts() noexcept;
 
+/** Returns the original ghost of the given personality, i.e. at index number(id), or nullptr. */
 ghost_ref ghost(const ghost_t::personality_t id) noexcept;
 
 typedef std::shared_ptr<pacman_t> pacman_ref;
@@ -508,6 +733,21 @@ constexpr int number(const audio_clip_t item) noexcept {
 typedef std::shared_ptr<audio_sample_t> audio_sample_ref;
 extern std::vector<audio_sample_ref> audio_samples;
 
+/**
+ * Requests playing the given clip on the audio thread without blocking, see audio_queue_t::play().
+ *
+ * Shall only be called by the thread stepping the simulation.
+ * @param loops pass 0 for infinity, otherwise the number of loops. Defaults to 1.
+ */
+void audio_play(const audio_clip_t clip, const int loops=1) noexcept;
+
+/**
+ * Requests stopping the given clip on the audio thread without blocking, see audio_queue_t::stop().
+ *
+ * Shall only be called by the thread stepping the simulation.
+ */
+void audio_stop(const audio_clip_t clip) noexcept;
+
 /**
  * By default the original pacman behavior is being implemented:
  * - weighted (round) tile position for collision tests
@@ -40,6 +40,15 @@ int win_pixel_height() noexcept;
 int win_pixel_width() noexcept;
 int win_pixel_scale() noexcept;
 
+/** Returns the current window viewport_t, updated on window resize. */
+const viewport_t& win_viewport() noexcept;
+
+/**
+ * Returns the fixed simulation ticks per second,
+ * driving keyframei_t sub-tile steps and all animation and mode timers.
+ *
+ * The render frame rate is independent, see frame_snapshot_t interpolation.
+ */
 int get_frames_per_sec() noexcept;
 inline int get_ms_per_frame() noexcept { return (int)std::round(1000.0 / (float)get_frames_per_sec()); }
 
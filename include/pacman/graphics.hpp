@@ -31,12 +31,181 @@
 #include <map>
 #include <inttypes.h>
 #include <functional>
+#include <cmath>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_timer.h>
 #include <SDL2/SDL_ttf.h>
 
+//
+// viewport_t
+//
+
+/**
+ * Maze tile to window pixel transform, computed once per window resize, see win_viewport().
+ *
+ * Tile and sub-tile positions are mapped via integer lookup tables,
+ * avoiding the float multiply and rounding of maze_t::x_to_pixel() on the render hot path.
+ *
+ * Sub-tile positions are resolved at 1/sub_steps of a tile.
+ */
+class viewport_t {
+    public:
+        static constexpr const int sub_steps = 256;
+
+    private:
+        int win_width_, win_height_;
+        int offset_x_;
+        int scale_;
+        int ppt_x_, ppt_y_;
+        int width_, height_;
+        int dxy_;
+        /** scaled pixel position per tile index [0..width] and [0..height] */
+        std::vector<int> tile_x_, tile_y_;
+        /** scaled pixel offset per sub-tile step [0..sub_steps] */
+        std::vector<int> sub_x_, sub_y_;
+
+        static int to_pixel(const int v, const std::vector<int>& tile_lut, const int ppt) noexcept {
+            return 0 <= v && (size_t)v < tile_lut.size() ? tile_lut[v] : v * ppt;
+        }
+        static int to_pixel(const float v, const std::vector<int>& tile_lut, const std::vector<int>& sub_lut, const int ppt) noexcept {
+            const float v_i = std::floor(v);
+            const int sub = static_cast<int>( ( v - v_i ) * sub_steps + 0.5f );
+            return to_pixel(static_cast<int>(v_i), tile_lut, ppt) + sub_lut[sub];
+        }
+
+    public:
+        viewport_t() noexcept
+        : win_width_(0), win_height_(0), offset_x_(0), scale_(1), ppt_x_(0), ppt_y_(0), width_(0), height_(0), dxy_(0) {}
+
+        /**
+         * Recomputes the transform and its lookup tables.
+         * @param win_width window width in pixel
+         * @param win_height window height in pixel
+         * @param maze_width maze width in tiles
+         * @param maze_height maze height in tiles
+         * @param ppt_x unscaled pixel per tile in x direction
+         * @param ppt_y unscaled pixel per tile in y direction
+         * @param scale integer pixel scale
+         */
+        void reset(const int win_width, const int win_height, const int maze_width, const int maze_height,
+                   const int ppt_x, const int ppt_y, const int scale) noexcept;
+
+        constexpr int win_width() const noexcept { return win_width_; }
+        constexpr int win_height() const noexcept { return win_height_; }
+
+        /** Returns the horizontal window pixel offset of the centered maze */
+        constexpr int offset_x() const noexcept { return offset_x_; }
+
+        /** Returns the integer pixel scale */
+        constexpr int scale() const noexcept { return scale_; }
+
+        /** Returns the scaled maze width in pixel */
+        constexpr int pixel_width() const noexcept { return width_ * ppt_x_; }
+
+        /** Returns the scaled maze height in pixel */
+        constexpr int pixel_height() const noexcept { return height_ * ppt_y_; }
+
+        /** Returns the scaled sprite offset of texture_t::draw2_i() and texture_t::draw2_f(), i.e. one third tile */
+        constexpr int dxy() const noexcept { return dxy_; }
+
+        /** Returns the given unscaled pixel length scaled */
+        constexpr int scaled(const int v) const noexcept { return v * scale_; }
+
+        /** Returns the scaled pixel position of the tile position relative to the maze origin */
+        int x_to_pixel(const int x) const noexcept { return to_pixel(x, tile_x_, ppt_x_); }
+        int y_to_pixel(const int y) const noexcept { return to_pixel(y, tile_y_, ppt_y_); }
+        int x_to_pixel(const float x) const noexcept { return to_pixel(x, tile_x_, sub_x_, ppt_x_); }
+        int y_to_pixel(const float y) const noexcept { return to_pixel(y, tile_y_, sub_y_, ppt_y_); }
+
+        std::string toString() const noexcept;
+};
+
+//
+// tex_region_t and texture registry
+//
+
+/**
+ * Texture atlas region, i.e. a rectangle within a shared SDL_Texture.
+ *
+ * Instances are plain values, returned by value from the texture registry, see get_tex_region().
+ */
+struct tex_region_t {
+    SDL_Texture* tex;
+    int x, y, width, height;
+
+    constexpr bool is_valid() const noexcept { return nullptr != tex; }
+
+    /** Draws this region at the given tile position, see texture_t::draw(). */
+    void draw(SDL_Renderer* rend, const float x_pos, const float y_pos) const noexcept;
+
+    /** Draws this region at the given tile position with the sprite offset, see texture_t::draw2_f(). */
+    void draw2_f(SDL_Renderer* rend, const float x_pos, const float y_pos) const noexcept;
+
+    std::string toString() const noexcept;
+};
+
+/**
+ * 32-bit handle into the flat texture registry of tex_region_t.
+ *
+ * Zero is the invalid handle, resolving to an empty region.
+ */
+typedef uint32_t tex_handle_t;
+constexpr const tex_handle_t tex_handle_none = 0;
+
+/**
+ * Registers the given region and returns its handle.
+ *
+ * Registration shall be completed during initialization, before the simulation thread has started,
+ * since the registry is read without synchronization thereafter.
+ *
+ * @param tex the SDL_Texture, owned elsewhere, may be nullptr for an empty region
+ */
+tex_handle_t register_tex_region(SDL_Texture* tex, int x, int y, int w, int h) noexcept;
+
+/** Returns the registered region of the given handle by value, or an empty region if invalid. */
+tex_region_t get_tex_region(const tex_handle_t h) noexcept;
+
+/** Clears the texture registry, invalidating all handles. */
+void clear_tex_registry() noexcept;
+
+//
+// pre-scaled texture atlas
+//
+
+/**
+ * Adds the given SDL_Texture as a texture atlas to be pre-scaled by rescale_tex_atlases().
+ *
+ * Draws of regions within a pre-scaled atlas at its scale copy from the pre-scaled texture 1:1,
+ * i.e. the filtering cost of the `-pixqual` scale quality is paid once per window resize instead of each frame.
+ *
+ * The pre-scaled atlases are used by the rendering thread only and don't alter the texture registry.
+ * @param tex the source SDL_Texture, owned elsewhere
+ */
+void add_scaled_tex_atlas(SDL_Texture* tex) noexcept;
+
+/**
+ * (Re)builds all pre-scaled texture atlases at the given integer scale factor,
+ * to be called after the window has been resized or the render targets got reset.
+ *
+ * Each registered region within an atlas, see register_tex_region(), is scaled on its own
+ * with its edge pixels replicated, i.e. linear filtering doesn't bleed neighboring sprites into it.
+ * The renderer's target and draw color are preserved.
+ *
+ * Falls back to scaling each draw if render targets are not supported or the scale factor is one.
+ * @param rend
+ * @param scale
+ */
+void rescale_tex_atlases(SDL_Renderer* rend, const int scale) noexcept;
+
+/** Destroys all pre-scaled texture atlases and removes all added source textures. */
+void clear_scaled_tex_atlases() noexcept;
+
+//
+// texture_t
+//
+
 class texture_t {
     private:
         static std::atomic<int> counter;
@@ -81,6 +250,11 @@ class texture_t {
         constexpr int height() const noexcept { return height_; }
         constexpr SDL_Texture* sdl_texture() noexcept { return tex_; }
 
+        constexpr tex_region_t region() const noexcept { return tex_region_t { tex_, x_, y_, width_, height_ }; }
+
+        /** Registers this texture's region, see register_tex_region(). */
+        tex_handle_t register_region() const noexcept { return register_tex_region(tex_, x_, y_, width_, height_); }
+
         void draw_scaled_dimpos(SDL_Renderer* rend, const int x_pos, const int y_pos) noexcept;
         void draw_scaled_dim(SDL_Renderer* rend, const int x_pos, const int y_pos) noexcept;
         void draw(SDL_Renderer* rend, const int x_pos, const int y_pos) noexcept;
@@ -129,10 +303,32 @@ int add_sub_textures(std::vector<std::shared_ptr<texture_t>>& storage, SDL_Rende
                      const std::shared_ptr<texture_t>& global_texture, int x_off, int y_off, int w, int h,
                      const std::vector<tex_sub_coord_t>& tex_positions) noexcept;
 
+/**
+ * Add registered sub-texture handles to the storage list from given global texture owner,
+ * see register_tex_region().
+ *
+ * Out of bounds positions are added as tex_handle_none.
+ * @param storage
+ * @param global_texture
+ * @param x_off
+ * @param y_off
+ * @param w
+ * @param h
+ * @param tex_positions
+ * @return number of added handles
+ */
+int add_sub_textures(std::vector<tex_handle_t>& storage, const std::shared_ptr<texture_t>& global_texture,
+                     int x_off, int y_off, int w, int h, const std::vector<tex_sub_coord_t>& tex_positions) noexcept;
+
+/**
+ * Animated texture sequence of registered tex_handle_t, see register_tex_region().
+ */
 class animtex_t {
     private:
         std::string name_;
-        std::vector<std::shared_ptr<texture_t>> textures_;
+        std::vector<tex_handle_t> handles_;
+        /** owned textures of the file based constructors */
+        std::vector<std::shared_ptr<texture_t>> owned_;
 
         int ms_per_atex_;
         int atex_ms_left_;
@@ -140,7 +336,7 @@ class animtex_t {
         bool paused_;
 
     public:
-        animtex_t(std::string name, int ms_per_atex, const std::vector<std::shared_ptr<texture_t>>& textures) noexcept;
+        animtex_t(std::string name, int ms_per_atex, const std::vector<tex_handle_t>& handles) noexcept;
 
         animtex_t(std::string name, SDL_Renderer* rend, int ms_per_atex, const std::vector<const char*>& filenames) noexcept;
 
@@ -155,21 +351,21 @@ class animtex_t {
 
         void destroy() noexcept;
 
-        std::shared_ptr<texture_t> texture(const size_t idx) noexcept { return idx < textures_.size() ? textures_[idx] : nullptr; }
-        std::shared_ptr<const texture_t> texture(const size_t idx) const noexcept { return idx < textures_.size() ? textures_[idx] : nullptr; }
+        tex_handle_t handle(const size_t idx) const noexcept { return idx < handles_.size() ? handles_[idx] : tex_handle_none; }
+        tex_handle_t handle() const noexcept { return handle(animation_index_); }
 
-        std::shared_ptr<texture_t> texture() noexcept { return animation_index_ < textures_.size() ? textures_[animation_index_] : nullptr; }
-        std::shared_ptr<const texture_t> texture() const noexcept { return animation_index_ < textures_.size() ? textures_[animation_index_] : nullptr; }
+        tex_region_t texture(const size_t idx) const noexcept { return get_tex_region( handle(idx) ); }
+        tex_region_t texture() const noexcept { return get_tex_region( handle() ); }
 
-        int width() noexcept { std::shared_ptr<texture_t> tex = texture(); return nullptr!=tex ? tex->width() : 0; }
-        int height() noexcept { std::shared_ptr<texture_t> tex = texture(); return nullptr!=tex ? tex->height() : 0; }
+        int width() const noexcept { return texture().width; }
+        int height() const noexcept { return texture().height; }
 
         void reset() noexcept;
         void pause(bool enable) noexcept;
         void tick() noexcept;
 
-        void draw(SDL_Renderer* rend, const float x, const float y) noexcept;
-        void draw2(SDL_Renderer* rend, const float x, const float y) noexcept;
+        void draw(SDL_Renderer* rend, const float x, const float y) const noexcept;
+        void draw2(SDL_Renderer* rend, const float x, const float y) const noexcept;
 
         std::string toString() const noexcept;
 };
@@ -224,8 +420,32 @@ text_texture_ref draw_text_scaled(SDL_Renderer* rend, TTF_Font* font, const std:
                                   std::function<void(const texture_t& tex, int &x_, int&y_)> scaled_coord) noexcept;
 
 void draw_box(SDL_Renderer* rend, bool filled, int x_pixel_offset, int y_pixel_offset, float x, float y, float width, float height) noexcept;
+
+/**
+ * Queues a line using the current render draw color into the frame scoped line vertex buffer.
+ *
+ * Queued lines are rendered via flush_lines().
+ *
+ * @param rend
+ * @param pixel_width_scaled line width in window pixel
+ * @param x_pixel_offset
+ * @param y_pixel_offset
+ * @param x1
+ * @param y1
+ * @param x2
+ * @param y2
+ * @see flush_lines()
+ */
 void draw_line(SDL_Renderer* rend, int pixel_width_scaled, int x_pixel_offset, int y_pixel_offset, float x1, float y1, float x2, float y2) noexcept;
 
-void save_snapshot(SDL_Renderer* rend, const int width, const int height, const std::string& fname) noexcept;
+/**
+ * Renders all lines queued via draw_line() since the last flush
+ * using a single draw call if supported, i.e. SDL >= 2.0.18.
+ *
+ * The frame scoped vertex buffer is reserved once and cleared after rendering,
+ * hence no heap allocation occurs for line drawing.
+ * @param rend
+ */
+void flush_lines(SDL_Renderer* rend) noexcept;
 
 #endif /* PACMAN_GRAPHICS_HPP_ */
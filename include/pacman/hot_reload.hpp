@@ -0,0 +1,101 @@
+/*
+ * Author: Sven Gothel <sgothel@jausoft.com> and Svenson Han Gothel
+ * Copyright (c) 2022 Gothel Software e.K.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef PACMAN_HOT_RELOAD_HPP_
+#define PACMAN_HOT_RELOAD_HPP_
+
+#include <pacman/globals.hpp>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+
+//
+// hot_reload_t
+//
+
+/**
+ * Watches the maze file and the optional level specification file for changes on a background thread,
+ * using inotify on their directories to also catch editors replacing the file via rename.
+ *
+ * On change the maze incl. its derived tables and navigation graph, respectively the level specification,
+ * is rebuilt on the background thread and offered via take_maze() and take_level_spec(),
+ * to be swapped in by the game at the next level boundary.
+ */
+class hot_reload_t {
+    private:
+        static constexpr const bool DEBUG = false;
+        /** Quiet period after the last file event before reloading, coalescing partial writes */
+        static constexpr const int debounce_ms = 100;
+
+        struct watch_t {
+            int wd;
+            std::string dir;
+            std::string name;
+            bool is_maze;
+        };
+        std::string maze_fname;
+        std::string level_spec_fname;
+        std::vector<watch_t> watches;
+        int inotify_fd;
+        std::atomic<bool> running;
+        std::thread worker;
+
+        std::mutex mtx_pending;
+        std::unique_ptr<maze_t> pending_maze;
+        std::vector<game_level_spec_t> pending_level_spec;
+        std::atomic<bool> pending;
+
+        bool add_watch(const std::string& fname, const bool is_maze) noexcept;
+        void run() noexcept;
+        void reload(const bool maze, const bool level_spec) noexcept;
+
+    public:
+        /**
+         * @param maze_fname_ the maze file to watch
+         * @param level_spec_fname_ the level specification file to watch, may be empty
+         */
+        hot_reload_t(const std::string& maze_fname_, const std::string& level_spec_fname_) noexcept;
+        ~hot_reload_t() noexcept { stop(); }
+
+        hot_reload_t(const hot_reload_t&) = delete;
+        hot_reload_t& operator=(const hot_reload_t&) = delete;
+
+        /** Starts watching, returns false if inotify is not available. */
+        bool start() noexcept;
+        void stop() noexcept;
+
+        /** Returns true if a rebuilt maze or level specification is pending, lock free. */
+        bool has_pending() const noexcept { return pending; }
+
+        /** Returns the pending rebuilt maze or nullptr, transferring ownership. */
+        std::unique_ptr<maze_t> take_maze() noexcept;
+
+        /** Moves the pending level specification into dest and returns true, otherwise returns false. */
+        bool take_level_spec(std::vector<game_level_spec_t>& dest) noexcept;
+};
+
+#endif /* PACMAN_HOT_RELOAD_HPP_ */
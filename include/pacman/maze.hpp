@@ -53,6 +53,8 @@ enum class tile_t : int {
 constexpr int number(const tile_t item) noexcept {
     return static_cast<int>(item);
 }
+/** Number of tile_t values */
+constexpr const int tile_type_count = number(tile_t::KEY) + 1;
 std::string to_string(tile_t tile) noexcept;
 
 //
@@ -295,26 +297,314 @@ class acoord_t {
         std::string toIntString() const noexcept;
 };
 
+//
+// maze_bin_header_t
+//
+
+/**
+ * Header of the compiled binary maze file, written by maze_t::write_compiled() via `bin/maze_compile`.
+ *
+ * The file is mapped read-only via `mmap` and validated on load, avoiding all text parsing.
+ * Its tables are used in place, the tiles only copied into the active maze at the first level start.
+ * All fields are in host byte order, verified via `byte_order`.
+ *
+ * The row-major per tile tables follow the header at their given byte offsets:
+ * - `tiles_offset`: `int32_t` tile_t
+ * - `exits_offset`: `uint8_t` exits bitmask, see maze_t::exits()
+ * - `home_dist_offset`: `uint16_t` distance to the ghost home, see maze_t::home_distance()
+ *
+ * `checksum` is the 32-bit FNV-1a hash over all bytes following the header,
+ * while the header's positions and boxes are validated against its dimension.
+ *
+ * The file is written to a temporary file renamed over the target, leaving no partially written file behind.
+ */
+struct maze_bin_header_t {
+    static constexpr const char magic_value[8] = { 'P', 'M', 'M', 'A', 'Z', 'E', '0', '1' };
+    static constexpr const uint32_t version_value = 1;
+    static constexpr const uint32_t byte_order_value = 0x01020304;
+    /** Number of boxes, see `boxes` */
+    static constexpr const int box_count = 7;
+
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t header_size;
+    uint32_t file_size;
+    int32_t  width, height;
+    int32_t  ppt_x, ppt_y;
+    /** top-left, bottom-left, bottom-right and top-right scatter target [x, y] */
+    int32_t  scatter[4][2];
+    /** tunnel1, tunnel2, red_zone1, red_zone2, ghost_home_ext, ghost_home_int and ghost_start [x, y, width, height] */
+    int32_t  boxes[box_count][4];
+    float    pacman_start[2];
+    /** tile_t count, indexed by number(tile_t) */
+    int32_t  count[tile_type_count];
+    char     texture_file[64];
+    uint32_t tiles_offset;
+    uint32_t exits_offset;
+    uint32_t home_dist_offset;
+    uint32_t checksum;
+};
+
+static_assert( 324 == sizeof(maze_bin_header_t) && 7 == maze_bin_header_t::box_count && 13 == tile_type_count,
+               "compiled maze format changed, bump maze_bin_header_t::version_value and adjust this assertion" );
+
+//
+// layer_t
+//
+
+/**
+ * Bitboard layer of a maze_t::field_t, one bit per tile x in a 32-bit word per row y.
+ */
+enum class layer_t : int {
+    WALL = 0,
+    GATE = 1,
+    PELLET = 2,
+    PELLET_POWER = 3
+};
+constexpr int number(const layer_t item) noexcept {
+    return static_cast<int>(item);
+}
+
+/**
+ * Nonempty tile at its position, see maze_t::for_each_nonempty_tile().
+ */
+struct tile_pos_t {
+    float x, y;
+    tile_t tile;
+};
+
+//
+// nav_graph_t
+//
+
+class maze_t;
+
+/**
+ * Navigation graph of the maze's walkable tiles reachable from its ghost_start_box(),
+ * built at load time from the maze_t::exits() table.
+ *
+ * Intersections and dead ends, i.e. tiles with other than two exits, are nodes.
+ * The corridors in between are directed edges weighted by their length in tiles,
+ * including the wrapping tunnel corridors, which are flagged.
+ */
+class nav_graph_t {
+    public:
+        struct node_t {
+            int x, y;
+            /** Outgoing edge index per direction_t or -1 */
+            int edge[4];
+        };
+        struct edge_t {
+            int from, to;
+            /** Direction leaving the from node */
+            direction_t dir;
+            /** Direction arriving at the to node */
+            direction_t arrival_dir;
+            /** Length in tiles */
+            int length;
+            /** Passes a tunnel tile, see maze_t::is_tunnel() */
+            bool tunnel;
+        };
+
+    private:
+        std::vector<node_t> nodes_;
+        std::vector<edge_t> edges_;
+        /** Node index per tile or -1 */
+        std::vector<int> tile_node;
+        /** All pairs shortest path lengths, nodes_.size() squared if not exceeding max_apsp_nodes, otherwise empty */
+        std::vector<int> dist;
+        int width_;
+
+    public:
+        /** Maximum node count to precompute all pairs shortest paths, otherwise distance() walks the graph per query. */
+        static constexpr const size_t max_apsp_nodes = 256;
+
+        nav_graph_t() noexcept : width_(0) {}
+
+        /** Builds the graph from the given maze_t, replacing all content. */
+        void build(const maze_t& maze) noexcept;
+
+        const std::vector<node_t>& nodes() const noexcept { return nodes_; }
+        const std::vector<edge_t>& edges() const noexcept { return edges_; }
+
+        /** Returns the node index at the given tile position or -1 */
+        int node_at(const int x, const int y) const noexcept {
+            return 0 <= x && x < width_ && 0 <= y && (size_t)( y*width_+x ) < tile_node.size() ? tile_node[y*width_+x] : -1;
+        }
+
+        /** Returns the outgoing edge of the given node in the given direction or nullptr */
+        const edge_t* edge(const int node, const direction_t dir) const noexcept {
+            const int e = nodes_[node].edge[number(dir)];
+            return 0 <= e ? &edges_[e] : nullptr;
+        }
+
+        /** Returns the shortest path length in tiles between the given nodes or -1 if unreachable */
+        int distance(const int from, const int to) const noexcept;
+
+        std::string toString() const noexcept;
+};
+
+//
+// occupancy_grid_t
+//
+
+/**
+ * Per tile occupancy index of actors, each actor occupying its tile position, e.g. acoord_t::x_i() and y_i().
+ *
+ * Each tile heads an intrusive singly linked list of its actors, indexed by their actor number,
+ * hence moving an actor and querying a tile neighborhood are O(1) for a bounded number of actors per tile.
+ *
+ * Positions are clamped to the grid, keeping actors within a tunnel's wrap-around margin indexed.
+ */
+class occupancy_grid_t {
+    private:
+        int width_, height_;
+        /** First actor per tile index, or -1 */
+        std::vector<int> head;
+        /** Next actor within the same tile per actor, or -1 */
+        std::vector<int> next;
+        /** Tile index per actor, or -1 if not indexed */
+        std::vector<int> tile;
+
+        void unlink(const int actor) noexcept;
+
+    public:
+        occupancy_grid_t() noexcept
+        : width_(0), height_(0) {}
+
+        /** Clears and resizes this grid to the given dimension and number of actors. */
+        void reset(const int w, const int h, const int actor_count) noexcept;
+
+        constexpr int width() const noexcept { return width_; }
+        constexpr int height() const noexcept { return height_; }
+        int actor_count() const noexcept { return (int)tile.size(); }
+
+        /** Moves the given actor to the given tile, clamped to the grid, no-op if the tile is unchanged. */
+        void update(const int actor, const int x, const int y) noexcept;
+
+        /** Removes the given actor from the grid. */
+        void remove(const int actor) noexcept {
+            if( 0 <= actor && actor < actor_count() ) {
+                unlink(actor);
+            }
+        }
+
+        /**
+         * Calls `f(int actor)` for each actor within the given tile box `[x, x+w) x [y, y+h)`, clamped to the grid.
+         *
+         * Since acoord_t::intersects_f() implies tile positions differing at most by one,
+         * the box `x_i-1, y_i-1, 3, 3` yields all candidates intersecting an actor at `x_i, y_i`.
+         */
+        template<typename F>
+        void for_each_in_box(const int x, const int y, const int w, const int h, F f) const noexcept {
+            const int x0 = std::max(0, x), x1 = std::min(width_, x+w);
+            const int y0 = std::max(0, y), y1 = std::min(height_, y+h);
+            for(int yi=y0; yi<y1; ++yi) {
+                for(int xi=x0; xi<x1; ++xi) {
+                    for(int a = head[yi*width_+xi]; 0 <= a; a = next[a]) {
+                        f(a);
+                    }
+                }
+            }
+        }
+};
+
 //
 // maze_t
 //
 
 class maze_t {
     public:
+        static constexpr const int layer_count = 4;
+
         class field_t {
+            public:
+                /** Maximum width and height */
+                static constexpr const int max_dim = 2048;
+
             private:
                 int width_, height_;
+                /** Owned tiles, empty for a view(), see tile_data */
                 std::vector<tile_t> tiles;
-                int count_[13];
+                /** All tiles in row order, either owned tiles.data() or a read-only view(), e.g. of a mapped compiled maze */
+                const tile_t* tile_data;
+                int count_[tile_type_count];
+                /** Number of 32-bit words per bitboard row */
+                int words_per_row_;
+                /** Row bitboards, all layer_t of one row adjacent, i.e. `rows[(y*layer_count+layer)*words_per_row_+x/32]` */
+                std::vector<uint32_t> rows;
+                /** Tile indices of all pellets and power pellets in arbitrary order */
+                std::vector<int> items;
+                /** Position within items per tile index, or -1 */
+                std::vector<int> item_pos;
+
+                constexpr size_t word_idx(const int l, const int x, const int y) const noexcept {
+                    return (size_t)( y*layer_count+l ) * words_per_row_ + ( x >> 5 );
+                }
+
+                static constexpr int layer_of(const tile_t tile) noexcept {
+                    switch( tile ) {
+                        case tile_t::WALL: return number(layer_t::WALL);
+                        case tile_t::GATE: return number(layer_t::GATE);
+                        case tile_t::PELLET: return number(layer_t::PELLET);
+                        case tile_t::PELLET_POWER: return number(layer_t::PELLET_POWER);
+                        default: return -1;
+                    }
+                }
+                void set_bit(const int x, const int y, const tile_t tile) noexcept {
+                    const int l = layer_of(tile);
+                    if( 0 <= l ) {
+                        rows[word_idx(l, x, y)] |= 1U << ( x & 31 );
+                    }
+                }
+                void clear_bit(const int x, const int y, const tile_t tile) noexcept {
+                    const int l = layer_of(tile);
+                    if( 0 <= l ) {
+                        rows[word_idx(l, x, y)] &= ~( 1U << ( x & 31 ) );
+                    }
+                }
+
+                static constexpr bool is_item(const tile_t tile) noexcept {
+                    return tile_t::PELLET == tile || tile_t::PELLET_POWER == tile;
+                }
+                void add_item(const int idx) noexcept {
+                    item_pos[idx] = (int)items.size();
+                    items.push_back(idx);
+                }
+                /** Removes the given tile index from items in O(1), moving the last item into its place. */
+                void remove_item(const int idx) noexcept {
+                    const int pos = item_pos[idx];
+                    const int last = items.back();
+                    items[pos] = last;
+                    item_pos[last] = pos;
+                    items.pop_back();
+                    item_pos[idx] = -1;
+                }
+                /** Rebuilds items and item_pos from all tiles. */
+                void index_items() noexcept;
 
             public:
                 field_t() noexcept;
 
-                void set_dim(const int w, const int h) noexcept { width_=w; height_=h; }
+                /** Copies the given field into owned tiles, indexing its items if it is a view(). */
+                field_t(const field_t& o) noexcept;
+                field_t& operator=(const field_t& o) noexcept;
+
+                void set_dim(const int w, const int h) noexcept;
                 void add_tile(const tile_t tile) noexcept;
 
+                /**
+                 * Views the given w x h tiles with their given tile_t counts in place, i.e. without copying them.
+                 *
+                 * The tiles must outlive this field, e.g. mapped from a compiled maze file.
+                 * A view is read-only and its items are not indexed, see for_each_item(),
+                 * while a copy of it owns its tiles and items.
+                 */
+                void view(const int w, const int h, const tile_t* tiles_, const int32_t counts[]) noexcept;
+
                 void clear() noexcept;
-                bool validate_size() const noexcept { return tiles.size() == (size_t)width_ * (size_t)height_; }
+                bool validate_size() const noexcept { return tiles.size() == (size_t)width_ * (size_t)height_ && width_ <= max_dim && height_ <= max_dim; }
 
                 constexpr int width() const noexcept { return width_; }
                 constexpr int height() const noexcept { return height_; }
@@ -322,9 +612,53 @@ class maze_t {
                 constexpr int count(const tile_t tile) const noexcept { return count_[number(tile)]; }
 
                 tile_t tile(const int x, const int y) const noexcept;
-                tile_t tile_nc(const int x, const int y) const noexcept { return tiles[y*width_+x]; }
+                tile_t tile_nc(const int x, const int y) const noexcept { return tile_data[y*width_+x]; }
                 void set_tile(const int x, const int y, tile_t tile) noexcept;
 
+                /**
+                 * Restores the consumed pellets and power pellets of the given source field in place,
+                 * iterating over the missing bits of their row bitboards,
+                 * as well as the given tile position, e.g. the fruit.
+                 *
+                 * All other tiles are expected to be unchanged, i.e. no allocation nor full copy is performed.
+                 */
+                void restore_consumables(const field_t& src, const int x, const int y) noexcept;
+
+                constexpr int words_per_row() const noexcept { return words_per_row_; }
+
+                /**
+                 * Returns the 32-bit word of bitboard row y of the given layer,
+                 * bit `x % 32` set for each such tile x within word `x / 32`, or zero if out of bounds.
+                 */
+                uint32_t row_word(const layer_t layer, const int y, const int word) const noexcept {
+                    return 0 <= y && y < height_ && 0 <= word && word < words_per_row_ ? rows[word_idx(number(layer), word << 5, y)] : 0;
+                }
+
+                /** Returns the number of pellets and power pellets, see for_each_item(). */
+                int item_count() const noexcept { return (int)items.size(); }
+
+                /**
+                 * Calls `f(int x, int y, tile_t tile)` for each pellet and power pellet in arbitrary order,
+                 * using the maintained list of occupied tiles instead of scanning all tiles.
+                 */
+                template<typename F>
+                void for_each_item(F f) const noexcept {
+                    for(const int idx : items) {
+                        f(idx % width_, idx / width_, tile_data[idx]);
+                    }
+                }
+
+                /** Calls `f(int x, int y, tile_t tile)` for each tile in row order. */
+                template<typename F>
+                void for_each_tile(F f) const noexcept {
+                    for(int y=0; y<height_; ++y) {
+                        const tile_t* row = tile_data + (size_t)y*width_;
+                        for(int x=0; x<width_; ++x) {
+                            f(x, y, row[x]);
+                        }
+                    }
+                }
+
                 std::string toString() const noexcept;
         };
     private:
@@ -346,17 +680,51 @@ class maze_t {
         std::string texture_file;
         field_t active;
         field_t original;
+        uint64_t modcount_;
 
         // derived data
         acoord_t fruit_pos_;
         box_t message_box_;
 
+        // derived per tile tables, either owned in derived_tables or mapped from a compiled file
+        std::vector<uint8_t> derived_tables;
+        const uint8_t* exits_;
+        const uint16_t* home_dist_;
+        void* map_addr;
+        size_t map_size;
+        nav_graph_t nav_graph_;
+
         bool digest_iposition_line(const std::string& name, acoord_t& dest, const std::string& line) noexcept;
         bool digest_fposition_line(const std::string& name, acoord_t& dest, const std::string& line) noexcept;
         bool digest_ibox_line(const std::string& name, box_t& dest, const std::string& line) noexcept;
 
+        bool parse_text(const std::string& fname) noexcept;
+        bool load_compiled(const std::string& fname) noexcept;
+        void compute_derived_tables() noexcept;
+        void unmap() noexcept;
+
     public:
+        /** exits() bitmask flag: tile is inside tunnel1_box() or tunnel2_box(). */
+        static constexpr const uint8_t TILE_TUNNEL = 0x10;
+        /** exits() bitmask flag: tile is inside red_zone1_box() or red_zone2_box(). */
+        static constexpr const uint8_t TILE_RED_ZONE = 0x20;
+
+        /** Returns true if the given file starts with the maze_bin_header_t magic. */
+        static bool is_compiled_file(const std::string& fname) noexcept;
+
+        /**
+         * Loads the given maze file,
+         * either a compiled binary maze file, see is_compiled_file() and write_compiled(),
+         * or the text maze file, e.g. `media/playfield_pacman.txt`.
+         */
         maze_t(const std::string& fname) noexcept;
+        ~maze_t() noexcept;
+
+        maze_t(const maze_t&) = delete;
+        maze_t& operator=(const maze_t&) = delete;
+
+        /** Returns true if loaded from a mapped compiled binary maze file. */
+        constexpr bool is_compiled() const noexcept { return nullptr != map_addr; }
 
         constexpr bool is_ok() const noexcept { return active.width() > 0 && active.height() > 0; };
 
@@ -417,10 +785,129 @@ class maze_t {
         constexpr int max(const tile_t tile) const noexcept { return original.count(tile); }
 
         tile_t tile(const int x, const int y) const noexcept { return active.tile(x, y); }
-        void set_tile(const int x, const int y, tile_t tile) noexcept { active.set_tile(x, y, tile); }
 
-        void draw(std::function<void(const float x_pos, const float y_pos, tile_t tile)> draw_pixel) noexcept;
+        /** Returns the number of 32-bit words per bitboard row, see row_word(). */
+        constexpr int words_per_row() const noexcept { return active.words_per_row(); }
+
+        /** Returns the active bitboard row word, see field_t::row_word(). */
+        uint32_t row_word(const layer_t layer, const int y, const int word) const noexcept { return active.row_word(layer, y, word); }
+
+        /** Returns true if the active tile is of the given layer, via its bitboard. */
+        bool test(const layer_t layer, const int x, const int y) const noexcept {
+            return 0 <= x && x < width() && 0 != ( row_word(layer, y, x >> 5) & ( 1U << ( x & 31 ) ) );
+        }
+
+        /**
+         * Returns the number of active tiles of the given layer within the given region,
+         * i.e. the popcount of the masked bitboard rows.
+         */
+        int count(const layer_t layer, const box_t& region) const noexcept;
+
+        /**
+         * Copies all active bitboard rows into dest, reusing its capacity,
+         * see field_t::row_word(). The maze fits into height() x layer_count x words_per_row() words.
+         */
+        void copy_bitboards(std::vector<uint32_t>& dest) const noexcept;
+        void set_tile(const int x, const int y, tile_t tile) noexcept { active.set_tile(x, y, tile); ++modcount_; }
+
+        /** Returns the modification counter of the active tiles, incremented by set_tile() and reset(). */
+        constexpr uint64_t modcount() const noexcept { return modcount_; }
+
+        /** Continues the modification counter of the replaced maze, keeping modcount() monotonic across a swap. */
+        void inherit_modcount(const maze_t& prev) noexcept { modcount_ = std::max(modcount_, prev.modcount_) + 1; }
+
+        /**
+         * Returns true if the given maze has the same dimension, pixel per tile, texture and ghost house,
+         * i.e. may replace this maze while running, see `-hot_reload`.
+         */
+        bool same_layout(const maze_t& o) const noexcept {
+            return width() == o.width() && height() == o.height() && ppt_x_ == o.ppt_x_ && ppt_y_ == o.ppt_y_ &&
+                   texture_file == o.texture_file && ghost_home_int == o.ghost_home_int && ghost_start == o.ghost_start;
+        }
 
+        /** Returns the original bitboard row word, immutable after loading, see field_t::row_word(). */
+        uint32_t original_row_word(const layer_t layer, const int y, const int word) const noexcept { return original.row_word(layer, y, word); }
+
+        /**
+         * Calls `f(int x, int y, tile_t tile)` for each active tile in row order,
+         * including the fruit at its integer tile position.
+         */
+        template<typename F>
+        void for_each_tile(F f) const noexcept { active.for_each_tile(f); }
+
+        /**
+         * Calls `f(float x, float y, tile_t tile)` for each active pellet and power pellet in arbitrary order,
+         * followed by the fruit at fruit_pos() if present.
+         *
+         * Only the maintained list of occupied tiles is visited,
+         * i.e. the cost is proportional to the number of remaining pellets.
+         */
+        template<typename F>
+        void for_each_nonempty_tile(F f) const noexcept {
+            active.for_each_item([&f](const int x, const int y, const tile_t tile) { f((float)x, (float)y, tile); });
+            const tile_t fruit = active.tile(fruit_pos_.x_i(), fruit_pos_.y_i());
+            if( number(tile_t::CHERRY) <= number(fruit) && number(fruit) <= number(tile_t::KEY) ) {
+                f(fruit_pos_.x_f(), fruit_pos_.y_f(), fruit);
+            }
+        }
+
+        /** Copies all active nonempty tiles into dest, reusing its capacity, see for_each_nonempty_tile(). */
+        void copy_nonempty_tiles(std::vector<tile_pos_t>& dest) const noexcept {
+            dest.clear();
+            for_each_nonempty_tile([&dest](const float x, const float y, const tile_t tile) { dest.push_back( { x, y, tile } ); });
+        }
+
+        /**
+         * Returns the precomputed exits bitmask of the given tile,
+         * having bit `1 << number(direction_t)` set if the neighbor in that direction is walkable, i.e. neither WALL nor GATE,
+         * wrapping around the maze borders.
+         *
+         * Additionally flags TILE_TUNNEL and TILE_RED_ZONE are set.
+         *
+         * Returns zero if out of bounds.
+         */
+        uint8_t exits(const int x, const int y) const noexcept {
+            return 0 <= x && x < width() && 0 <= y && y < height() ? exits_[y*width()+x] : 0;
+        }
+        bool can_exit(const int x, const int y, const direction_t dir) const noexcept {
+            return 0 != ( exits(x, y) & ( 1 << number(dir) ) );
+        }
+        bool is_tunnel(const int x, const int y) const noexcept { return 0 != ( exits(x, y) & TILE_TUNNEL ); }
+        bool is_red_zone(const int x, const int y) const noexcept { return 0 != ( exits(x, y) & TILE_RED_ZONE ); }
+
+        /**
+         * Returns the precomputed walking distance in tiles to the ghost_start_box(), saturated at 65534,
+         * or -1 if unreachable or out of bounds.
+         */
+        int home_distance(const int x, const int y) const noexcept {
+            if( 0 <= x && x < width() && 0 <= y && y < height() ) {
+                const uint16_t d = home_dist_[y*width()+x];
+                return 0xffff != d ? d : -1;
+            }
+            return -1;
+        }
+
+        /** Returns the navigation graph, built at load time. */
+        const nav_graph_t& nav_graph() const noexcept { return nav_graph_; }
+
+        /**
+         * Writes this maze as a compiled binary maze file, see maze_bin_header_t.
+         * @return true if successful
+         */
+        bool write_compiled(const std::string& fname) const noexcept;
+
+        /**
+         * Returns the FNV-1a checksum of the original maze,
+         * i.e. its dimension, pixel per tile, key positions and boxes as well as all original tiles.
+         *
+         * Equal checksums denote the same game simulation, regardless of text or compiled file source.
+         */
+        uint32_t checksum() const noexcept;
+
+        /**
+         * Resets the active tiles to the original maze,
+         * restoring only the consumed pellets, power pellets and the fruit in place after the initial copy.
+         */
         void reset() noexcept;
 
         std::string toString() const noexcept;
@@ -0,0 +1,537 @@
+/*
+ * Author: Sven Gothel <sgothel@jausoft.com> and Svenson Han Gothel
+ * Copyright (c) 2022 Gothel Software e.K.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef PACMAN_RECORDER_HPP_
+#define PACMAN_RECORDER_HPP_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cinttypes>
+#include <cstdio>
+
+#include <SDL2/SDL.h>
+
+//
+// record_policy_t
+//
+
+/**
+ * Policy of frame_recorder_t when all frame buffers are in use, i.e. the writer queue is full.
+ */
+enum class record_policy_t : uint8_t {
+    /** Wait for a free frame buffer, i.e. throttle the rendering thread. */
+    BLOCK,
+    /** Drop the frame. */
+    DROP,
+    /** Halve the recorded frame rate each time the queue runs full, restored once the queue has drained. */
+    DEGRADE
+};
+std::string to_string(const record_policy_t p) noexcept;
+
+/**
+ * Parses the given policy name, i.e. `block`, `drop` or `degrade`.
+ * @return true if name is valid and policy has been set, otherwise false
+ */
+bool to_record_policy(const std::string& name, record_policy_t& policy) noexcept;
+
+//
+// record_format_t
+//
+
+/**
+ * Image file format of frame snapshots and recorded frame sequences.
+ */
+enum class record_format_t : uint8_t {
+    /** Uncompressed bmp */
+    BMP,
+    /** Compressed png, see IMG_SavePNG() */
+    PNG,
+    /** Compressed QOI, the Quite OK Image format, encoded in parallel stripes */
+    QOI
+};
+/** Returns the format name, being the file name extension as well. */
+std::string to_string(const record_format_t f) noexcept;
+
+/**
+ * Parses the given format name, i.e. `bmp`, `png` or `qoi`.
+ * @return true if name is valid and format has been set, otherwise false
+ */
+bool to_record_format(const std::string& name, record_format_t& format) noexcept;
+
+//
+// stripe_pool_t
+//
+
+/**
+ * Fixed-size thread pool executing the stripes of a frame in parallel.
+ *
+ * The calling thread executes the first stripe of its run() itself, the pool threads the others.
+ * run() may be called concurrently by multiple threads, e.g. frame_recorder_t writer threads,
+ * where each caller helps executing queued stripes until its own have been completed.
+ */
+class stripe_pool_t {
+    private:
+        struct batch_t {
+            const std::function<void(int)>* fn;
+            int left;
+        };
+        struct task_t {
+            batch_t* batch;
+            int idx;
+        };
+        std::deque<task_t> tasks_;
+        std::vector<std::thread> threads_;
+        std::mutex mtx_;
+        std::condition_variable cv_tasks_;
+        std::condition_variable cv_done_;
+        bool running_;
+
+        /** Executes the given task and completes it, returns with lock held */
+        void execute(std::unique_lock<std::mutex>& lock, const task_t& t) noexcept;
+
+        void thread_main() noexcept;
+
+    public:
+        /**
+         * @param thread_count number of pool threads besides the calling thread, zero for the number of hardware threads minus one
+         */
+        stripe_pool_t(const size_t thread_count=0) noexcept;
+
+        stripe_pool_t(const stripe_pool_t&) = delete;
+        void operator=(const stripe_pool_t&) = delete;
+
+        ~stripe_pool_t() noexcept;
+
+        /** Returns the number of stripes executed in parallel, i.e. the pool threads plus the calling thread */
+        size_t size() const noexcept { return threads_.size() + 1; }
+
+        /** Executes fn(i) for i in [0, count) in parallel and returns after all have been completed. */
+        void run(const int count, const std::function<void(int)>& fn) noexcept;
+};
+
+//
+// frame_writer_t
+//
+
+/**
+ * Frame writer used by the frame_recorder_t writer threads.
+ */
+class frame_writer_t {
+    public:
+        virtual ~frame_writer_t() noexcept = default;
+
+        /** Returns true if frames must be written in order, i.e. by a single writer thread. */
+        virtual bool sequential() const noexcept = 0;
+
+        /**
+         * Writes the given ARGB8888 frame.
+         * @param frame the frame buffer
+         * @param fname the frame's file name, may be ignored by stream writer
+         * @param frame_no the frame's number, counting dropped frames as well
+         * @return true if successful
+         */
+        virtual bool write(SDL_Surface* frame, const std::string& fname, const uint64_t frame_no) noexcept = 0;
+
+        virtual std::string toString() const noexcept = 0;
+};
+
+/**
+ * Writes each frame as a bmp file, allowing parallel writer threads.
+ */
+class bmp_writer_t : public frame_writer_t {
+    public:
+        bool sequential() const noexcept override { return false; }
+        bool write(SDL_Surface* frame, const std::string& fname, const uint64_t frame_no) noexcept override;
+        std::string toString() const noexcept override { return "bmp"; }
+};
+
+/**
+ * Writes each frame as a png file, allowing parallel writer threads.
+ */
+class png_writer_t : public frame_writer_t {
+    public:
+        bool sequential() const noexcept override { return false; }
+        bool write(SDL_Surface* frame, const std::string& fname, const uint64_t frame_no) noexcept override;
+        std::string toString() const noexcept override { return "png"; }
+};
+
+/**
+ * Writes each frame as a QOI file, allowing parallel writer threads.
+ *
+ * Each frame is split into horizontal stripes encoded in parallel on a stripe_pool_t.
+ * Every stripe starts with an explicit RGBA pixel and only references colors indexed within itself,
+ * hence the concatenated stripes form one valid QOI stream.
+ */
+class qoi_writer_t : public frame_writer_t {
+    private:
+        stripe_pool_t& pool_;
+
+    public:
+        qoi_writer_t(stripe_pool_t& pool) noexcept
+        : pool_(pool) {}
+
+        bool sequential() const noexcept override { return false; }
+        bool write(SDL_Surface* frame, const std::string& fname, const uint64_t frame_no) noexcept override;
+        std::string toString() const noexcept override { return "qoi[stripes "+std::to_string(pool_.size())+"]"; }
+};
+
+/**
+ * Returns a new writer for the given image format.
+ * @param pool the stripe pool used by record_format_t::QOI, may be nullptr for all other formats
+ */
+std::unique_ptr<frame_writer_t> make_image_writer(const record_format_t format, stripe_pool_t* pool) noexcept;
+
+/**
+ * Appends all frames to one YUV4MPEG2 stream, i.e. a file, a FIFO or stdout,
+ * readable by common encoder like `ffmpeg -i video.y4m`.
+ *
+ * Frames are stored in full resolution YUV 4:4:4 using BT.601 coefficients.
+ * The stream's dimension is set by the first frame, frames of different size are skipped.
+ */
+class y4m_writer_t : public frame_writer_t {
+    private:
+        std::string fname_;
+        FILE* out_;
+        int fps_;
+        /** set by the writer thread with the first frame, height_ before width_, read by toString() */
+        std::atomic<int> width_, height_;
+        std::vector<uint8_t> planes_;
+        std::atomic<uint64_t> frames_skipped_;
+
+    public:
+        /**
+         * @param fname the file name or `-` for stdout
+         * @param fps the frame rate stored in the stream header
+         */
+        y4m_writer_t(const std::string& fname, const int fps) noexcept;
+
+        y4m_writer_t(const y4m_writer_t&) = delete;
+        void operator=(const y4m_writer_t&) = delete;
+
+        ~y4m_writer_t() noexcept override;
+
+        bool is_open() const noexcept { return nullptr != out_; }
+
+        bool sequential() const noexcept override { return true; }
+        bool write(SDL_Surface* frame, const std::string& fname, const uint64_t frame_no) noexcept override;
+        std::string toString() const noexcept override;
+};
+
+/**
+ * Rectangle of a delta_writer_t frame.
+ */
+struct delta_rect_t {
+    uint32_t x, y, width, height;
+};
+
+/**
+ * Appends all frames to one delta stream file, eliding duplicate frames and storing changed rectangles only.
+ *
+ * Stream layout, all values in host byte order:
+ * - header: magic `PMDELTA1`, uint32_t width, height and fps
+ * - per stored frame: uint64_t frame number, uint32_t rectangle count,
+ *   followed by each delta_rect_t and its ARGB8888 pixel rows
+ *
+ * Exact duplicates of the previous frame, detected by their hash and confirmed by comparison, are not stored.
+ * Hence a frame number missing in the stream repeats the previous frame,
+ * while a stored frame without rectangles marks the last frame's number.
+ *
+ * Every key_interval stored frames, a key frame covering the whole frame is stored, starting with the first one.
+ * Frames not matching the first frame's dimension are skipped and logged.
+ *
+ * See delta_reader_t and `bin/pacman_delta2y4m`.
+ */
+class delta_writer_t : public frame_writer_t {
+    public:
+        static constexpr const char* magic = "PMDELTA1";
+        static constexpr const int block_size = 32;
+        static constexpr const uint64_t key_interval = 600;
+
+    private:
+        std::string fname_;
+        FILE* out_;
+        int fps_;
+        /** set by the writer thread with the first frame, height_ before width_, read by toString() */
+        std::atomic<int> width_, height_;
+        std::vector<uint32_t> prev_;
+        std::vector<uint32_t> cur_;
+        uint64_t prev_hash_;
+        uint64_t last_frame_no_;
+        bool last_elided_;
+        std::vector<delta_rect_t> rects_;
+        std::atomic<uint64_t> frames_stored_, frames_elided_, frames_skipped_, bytes_written_;
+
+        bool write_frame(const uint64_t frame_no, const uint32_t* pixels) noexcept;
+
+    public:
+        /**
+         * @param fname the file name
+         * @param fps the frame rate stored in the stream header
+         */
+        delta_writer_t(const std::string& fname, const int fps) noexcept;
+
+        delta_writer_t(const delta_writer_t&) = delete;
+        void operator=(const delta_writer_t&) = delete;
+
+        /** Marks an elided last frame and closes the file */
+        ~delta_writer_t() noexcept override;
+
+        bool is_open() const noexcept { return nullptr != out_; }
+
+        bool sequential() const noexcept override { return true; }
+        bool write(SDL_Surface* frame, const std::string& fname, const uint64_t frame_no) noexcept override;
+        std::string toString() const noexcept override;
+};
+
+/**
+ * Reads a delta stream written by delta_writer_t.
+ *
+ * The header's dimension is validated against the file size and the mandatory leading key frame,
+ * a malformed or truncated stream is logged and reported via has_error().
+ */
+class delta_reader_t {
+    private:
+        FILE* in_;
+        int width_, height_, fps_;
+        std::vector<uint32_t> frame_;
+        uint64_t frame_no_;
+        uint64_t frames_read_;
+        bool error_;
+
+        bool fail(const char* what) noexcept;
+
+    public:
+        delta_reader_t(const std::string& fname) noexcept;
+
+        delta_reader_t(const delta_reader_t&) = delete;
+        void operator=(const delta_reader_t&) = delete;
+
+        ~delta_reader_t() noexcept;
+
+        /** Returns true if the file is open and its header is valid */
+        bool is_open() const noexcept { return nullptr != in_; }
+
+        int width() const noexcept { return width_; }
+        int height() const noexcept { return height_; }
+        int fps() const noexcept { return fps_; }
+
+        /**
+         * Reads the next stored frame and applies its rectangles to pixels().
+         * @return true if successful, false at end of stream or on error
+         */
+        bool next() noexcept;
+
+        /** Returns the current frame's number */
+        uint64_t frame_no() const noexcept { return frame_no_; }
+
+        /** Returns true if the stream is malformed or truncated, i.e. next() didn't end at end of stream */
+        bool has_error() const noexcept { return error_; }
+
+        /** Returns the current frame's ARGB8888 pixels, width() pixel per row */
+        const uint32_t* pixels() const noexcept { return frame_.data(); }
+};
+
+//
+// frame_recorder_t
+//
+
+/**
+ * Records rendered frames via a frame_writer_t using a fixed-size pool of writer threads
+ * and a bounded queue of reusable SDL_Surface frame buffers.
+ *
+ * A sequential frame_writer_t is served by a single writer thread.
+ * The writer threads are started with the first queued frame, i.e. an unused recorder costs no thread.
+ *
+ * record() must be called from the rendering thread only.
+ */
+class frame_recorder_t {
+    private:
+        struct job_t {
+            size_t buffer_idx;
+            std::string fname;
+            uint64_t frame_no;
+        };
+        const record_policy_t policy_;
+        std::unique_ptr<frame_writer_t> writer_;
+        std::vector<SDL_Surface*> buffers_;
+        std::vector<size_t> free_buffers_;
+        std::deque<job_t> queue_;
+        /** number of writer threads to start with the first queued frame */
+        const size_t worker_count_;
+        std::vector<std::thread> workers_;
+        std::mutex mtx_;
+        std::condition_variable cv_free_;
+        std::condition_variable cv_queue_;
+        bool running_;
+
+        std::atomic<size_t> queue_depth_;
+        size_t queue_depth_max_;
+        std::atomic<uint64_t> frames_written_;
+        std::atomic<uint64_t> frames_dropped_;
+        /** number of frames the writer failed to write */
+        std::atomic<uint64_t> frames_failed_;
+        /** number of record() calls, rendering thread only */
+        uint64_t frames_submitted_;
+
+        /** DEGRADE: only every degrade_nth_ frame is recorded, rendering thread only */
+        uint64_t degrade_nth_;
+        uint64_t degrade_count_;
+
+        void worker_main() noexcept;
+
+        /**
+         * Returns a free frame buffer index of the given size according to the policy,
+         * or -1 if the frame shall be dropped.
+         */
+        int acquire(const int width, const int height) noexcept;
+
+        /** Returns the acquired frame buffer unwritten, counting the frame as dropped. */
+        void drop(const size_t buffer_idx) noexcept;
+
+        void enqueue(const size_t buffer_idx, const std::string& fname, const uint64_t frame_no) noexcept;
+
+    public:
+        /**
+         * @param writer the frame writer
+         * @param buffer_count number of frame buffers, i.e. the maximum queue depth
+         * @param worker_count number of writer threads, reduced to one for a sequential writer
+         * @param policy policy if all frame buffers are in use
+         */
+        frame_recorder_t(std::unique_ptr<frame_writer_t> writer, const size_t buffer_count, const size_t worker_count, const record_policy_t policy) noexcept;
+
+        frame_recorder_t(const frame_recorder_t&) = delete;
+        void operator=(const frame_recorder_t&) = delete;
+
+        ~frame_recorder_t() noexcept {
+            stop();
+        }
+
+        /**
+         * Writes all queued frames, stops the writer threads and releases all frame buffers.
+         *
+         * Logs the statistics if frames have been written, dropped or failed.
+         */
+        void stop() noexcept;
+
+        /**
+         * Reads back the current render target of given size and queues it for writing.
+         * @return true if the frame has been queued, false if dropped, including a failed read back
+         */
+        bool record(SDL_Renderer* rend, const int width, const int height, const std::string& fname) noexcept;
+
+        /**
+         * Copies the given surface, e.g. the headless render target, and queues it for writing.
+         * @return true if the frame has been queued, false if dropped
+         */
+        bool record(SDL_Surface* surface, const std::string& fname) noexcept;
+
+        record_policy_t policy() const noexcept { return policy_; }
+
+        /** Returns the number of frames queued or being written. */
+        size_t queue_depth() const noexcept { return queue_depth_; }
+
+        /** Returns the maximum observed queue_depth(). */
+        size_t queue_depth_max() const noexcept { return queue_depth_max_; }
+
+        uint64_t frames_written() const noexcept { return frames_written_; }
+        uint64_t frames_dropped() const noexcept { return frames_dropped_; }
+        /** Returns the number of queued frames the writer failed to write. */
+        uint64_t frames_failed() const noexcept { return frames_failed_; }
+
+        std::string toString() const noexcept;
+};
+
+//
+// render_capture_t
+//
+
+/**
+ * Double-buffered render target capture for frame_recorder_t.
+ *
+ * Each frame is rendered into one of two SDL_TEXTUREACCESS_TARGET textures and blitted to the window,
+ * while the previous frame's target is read back at the start of the next frame.
+ * The readback itself stays synchronous, SDL 2 offers no asynchronous one,
+ * but it avoids waiting on the in-flight frame, since frame N-1 has been completed while presenting.
+ *
+ * The targets shall be reset() on SDL_RENDER_TARGETS_RESET and SDL_RENDER_DEVICE_RESET,
+ * as their content may be lost, e.g. on Direct3D or some OpenGL backends.
+ *
+ * All methods must be called from the rendering thread only.
+ */
+class render_capture_t {
+    private:
+        SDL_Texture* targets_[2];
+        int width_, height_;
+        int current_;
+        bool pending_;
+        std::string pending_fname_;
+
+        void destroy_targets() noexcept;
+
+    public:
+        render_capture_t() noexcept
+        : targets_{ nullptr, nullptr }, width_(0), height_(0), current_(0), pending_(false) {}
+
+        render_capture_t(const render_capture_t&) = delete;
+        void operator=(const render_capture_t&) = delete;
+
+        ~render_capture_t() noexcept {
+            destroy_targets();
+        }
+
+        /**
+         * Begins a frame of given size by reading back the pending previous frame into the recorder
+         * and setting the current target texture as the render target.
+         * @return true if capturing, false if render targets are not supported, i.e. render to the window directly
+         */
+        bool begin(SDL_Renderer* rend, const int width, const int height, frame_recorder_t& recorder) noexcept;
+
+        /**
+         * Ends the frame started by begin(), blits the current target to the window
+         * and marks it pending for readback with the given file name.
+         */
+        void end(SDL_Renderer* rend, const std::string& fname) noexcept;
+
+        /** Reads back a pending frame into the recorder, e.g. before stopping the recorder. */
+        void flush(SDL_Renderer* rend, frame_recorder_t& recorder) noexcept;
+
+        /** Releases the target textures, a pending frame is discarded. */
+        void destroy() noexcept {
+            destroy_targets();
+        }
+
+        /**
+         * Drops a pending frame and releases the target textures after their content got lost,
+         * they are re-created by the next begin().
+         */
+        void reset() noexcept;
+};
+
+#endif /* PACMAN_RECORDER_HPP_ */
@@ -26,7 +26,11 @@
 
 #include <string>
 #include <memory>
+#include <new>
+#include <utility>
 #include <random>
+#include <atomic>
+#include <array>
 
 #include <cstdint>
 #include <cstdarg>
@@ -288,6 +292,9 @@ class box_t {
         constexpr float center_x() const noexcept { return x_ + (float)w_/2.0f; }
         constexpr float center_y() const noexcept { return y_ + (float)h_/2.0f; }
 
+        constexpr bool operator==(const box_t& o) const noexcept { return x_ == o.x_ && y_ == o.y_ && w_ == o.w_ && h_ == o.h_; }
+        constexpr bool operator!=(const box_t& o) const noexcept { return !( *this == o ); }
+
         std::string toString() const noexcept;
 };
 
@@ -389,7 +396,7 @@ private:
     typedef std::mt19937 rand_puck_t;
     std::unique_ptr<rand_puck_t> rng_pm;
 
-    // if using puckman PRNG
+    // if using puckman PRNG or the last std::minstd_rand0 value, see state()
     result_type seed_;
 
 public:
@@ -463,7 +470,8 @@ public:
      */
     result_type operator()() noexcept {
         if constexpr ( random_engine_mode_t::STD_PRNG_0 == mode_type ) {
-            return (*rng_0)();
+            seed_ = (*rng_0)();
+            return seed_;
         } else if constexpr ( random_engine_mode_t::STD_RNG == mode_type ) {
             return (*rng_hw)();
         } else /* if constexpr ( random_engine_mode_t::PUCKMAN == mode_type ) */ {
@@ -489,13 +497,217 @@ public:
     void seed(result_type value) noexcept {
         if constexpr ( random_engine_mode_t::STD_PRNG_0 == mode_type ) {
             rng_0->seed(value);
+            seed_ = value;
         } else if constexpr ( random_engine_mode_t::STD_RNG == mode_type ) {
             // NOP ???
         } else /* if constexpr ( random_engine_mode_t::PUCKMAN == mode_type ) */ {
             seed_ = value;
         }
     }
+
+    /**
+     * Returns the internal state of a predictable PRNG,
+     * i.e. its last value or seed, continuing the same sequence once passed to seed().
+     *
+     * If is_rng() is true, i.e. using a non-predictable RNG, zero is returned.
+     *
+     * @see seed()
+     */
+    result_type state() const noexcept {
+        return seed_;
+    }
+};
+
+//
+// triple_buffer_t
+//
+
+/**
+ * Lock-free triple buffer for one producer and one consumer thread.
+ *
+ * The producer fills back() and hands it over via publish(),
+ * the consumer picks up the most recently published buffer via update() and reads it via front().
+ *
+ * Neither side ever blocks or waits for the other.
+ * Intermediate buffers are dropped if the producer is faster than the consumer.
+ *
+ * The producer receives a recycled buffer after publish(), hence shall overwrite its complete content.
+ */
+template<typename T>
+class triple_buffer_t {
+    private:
+        static constexpr const uint8_t dirty_bit = 0x04;
+        static constexpr const uint8_t index_mask = 0x03;
+
+        T buffers_[3];
+        /** index of the shared middle buffer, or'ed with dirty_bit if published and not yet consumed */
+        std::atomic<uint8_t> middle_;
+        /** producer owned */
+        uint8_t back_;
+        /** consumer owned */
+        uint8_t front_;
+
+    public:
+        triple_buffer_t() noexcept
+        : middle_(1), back_(0), front_(2) {}
+
+        triple_buffer_t(const triple_buffer_t&) = delete;
+        void operator=(const triple_buffer_t&) = delete;
+
+        /** Producer: Returns the buffer to be filled. */
+        T& back() noexcept { return buffers_[back_]; }
+
+        /** Producer: Publishes the filled back() buffer and acquires a recycled one. */
+        void publish() noexcept {
+            back_ = middle_.exchange( back_ | dirty_bit, std::memory_order_acq_rel ) & index_mask;
+        }
+
+        /**
+         * Consumer: Fetches the most recently published buffer, if any.
+         * @return true if front() has changed, otherwise false
+         */
+        bool update() noexcept {
+            if( 0 == ( middle_.load(std::memory_order_relaxed) & dirty_bit ) ) {
+                return false;
+            }
+            front_ = middle_.exchange( front_, std::memory_order_acq_rel ) & index_mask;
+            return true;
+        }
+
+        /** Consumer: Returns the most recently fetched buffer. */
+        const T& front() const noexcept { return buffers_[front_]; }
 };
 
+//
+// spsc_ring_t
+//
+
+/**
+ * Lock-free bounded ring buffer for one producer and one consumer thread.
+ *
+ * @tparam T trivially copyable element type
+ * @tparam Capacity number of elements, must be a power of two
+ */
+template<typename T, size_t Capacity>
+class spsc_ring_t {
+    private:
+        static_assert( 0 < Capacity && 0 == ( Capacity & ( Capacity - 1 ) ), "Capacity must be a power of two" );
+        static constexpr const size_t mask = Capacity - 1;
+
+        std::array<T, Capacity> data_;
+        /** consumer owned read position */
+        alignas(64) std::atomic<size_t> head_;
+        /** producer owned write position */
+        alignas(64) std::atomic<size_t> tail_;
+
+    public:
+        spsc_ring_t() noexcept
+        : data_(), head_(0), tail_(0) {}
+
+        spsc_ring_t(const spsc_ring_t&) = delete;
+        void operator=(const spsc_ring_t&) = delete;
+
+        constexpr size_t capacity() const noexcept { return Capacity; }
+
+        size_t size() const noexcept {
+            return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+        }
+
+        /**
+         * Producer: Appends the given element.
+         * @return true if successful, false if the ring is full
+         */
+        bool push(const T& v) noexcept {
+            const size_t t = tail_.load(std::memory_order_relaxed);
+            if( t - head_.load(std::memory_order_acquire) == Capacity ) {
+                return false;
+            }
+            data_[t & mask] = v;
+            tail_.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Consumer: Removes the oldest element.
+         * @return true if successful, false if the ring is empty
+         */
+        bool pop(T& v) noexcept {
+            const size_t h = head_.load(std::memory_order_relaxed);
+            if( h == tail_.load(std::memory_order_acquire) ) {
+                return false;
+            }
+            v = data_[h & mask];
+            head_.store(h + 1, std::memory_order_release);
+            return true;
+        }
+};
+
+//
+// inplace_array_t
+//
+
+/**
+ * Contiguous array of non-copyable and non-movable elements,
+ * its storage allocated once via reset() and each element constructed in place, never relocated.
+ *
+ * @tparam T element type, no copy or move required
+ */
+template<typename T>
+class inplace_array_t {
+    private:
+        T* data_;
+        size_t size_;
+        size_t capacity_;
+
+    public:
+        inplace_array_t() noexcept
+        : data_(nullptr), size_(0), capacity_(0) {}
+
+        ~inplace_array_t() noexcept { reset(0); }
+
+        inplace_array_t(const inplace_array_t&) = delete;
+        void operator=(const inplace_array_t&) = delete;
+
+        /** Destroys all elements and allocates storage for the given number of elements. */
+        void reset(const size_t capacity) noexcept {
+            clear();
+            std::allocator<T>().deallocate(data_, capacity_);
+            data_ = 0 < capacity ? std::allocator<T>().allocate(capacity) : nullptr;
+            capacity_ = capacity;
+        }
+
+        /** Destroys all elements in reverse order, keeping the storage. */
+        void clear() noexcept {
+            while( 0 < size_ ) {
+                data_[--size_].~T();
+            }
+        }
+
+        /**
+         * Constructs a new last element in place with the given arguments.
+         * @return the new element or nullptr if capacity() is exhausted
+         */
+        template<typename... Args>
+        T* emplace_back(Args&&... args) noexcept {
+            if( size_ == capacity_ ) {
+                return nullptr;
+            }
+            T* e = ::new( static_cast<void*>( data_ + size_ ) ) T( std::forward<Args>(args)... );
+            ++size_;
+            return e;
+        }
+
+        constexpr size_t size() const noexcept { return size_; }
+        constexpr size_t capacity() const noexcept { return capacity_; }
+        constexpr bool empty() const noexcept { return 0 == size_; }
+
+        T& operator[](const size_t i) noexcept { return data_[i]; }
+        const T& operator[](const size_t i) const noexcept { return data_[i]; }
+
+        T* begin() noexcept { return data_; }
+        T* end() noexcept { return data_ + size_; }
+        const T* begin() const noexcept { return data_; }
+        const T* end() const noexcept { return data_ + size_; }
+};
 
 #endif /* PACMAN_UTILS_HPP_ */
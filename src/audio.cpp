@@ -25,12 +25,21 @@
 #include <pacman/audio.hpp>
 #include <pacman/globals.hpp>
 
+#include <algorithm>
+#include <functional>
+#include <cerrno>
+#include <cinttypes>
+#include <cstring>
+#include <cstdio>
+
+#include <sys/stat.h>
+
 //
 // audio
 //
 
 bool audio_open(int mix_channels, int out_channel, int out_frequency, Uint16 out_sample_format, int out_chunksize) {
-    if( 0 != Mix_OpenAudio(out_frequency, AUDIO_S16SYS, out_channel, out_chunksize) ) {
+    if( 0 != Mix_OpenAudio(out_frequency, out_sample_format, out_channel, out_chunksize) ) {
         log_printf("SDL_mixer: Error Mix_OpenAudio: %s\n", SDL_GetError());
         return false;
     }
@@ -65,11 +74,17 @@ void audio_close() {
 }
 
 audio_sample_t::audio_sample_t(const std::string &fname, const bool single_play, const int volume)
-: chunk(Mix_LoadWAV(fname.c_str()), Mix_FreeChunk), channel_playing(-1), singly(single_play)
+: audio_sample_t(Mix_LoadWAV(fname.c_str()), single_play, volume)
 {
     if ( nullptr == chunk.get() ) {
         log_printf("Mix_LoadWAV: Load '%s' Error: %s\n", fname.c_str(), SDL_GetError());
-    } else {
+    }
+}
+
+audio_sample_t::audio_sample_t(Mix_Chunk* chunk_, const bool single_play, const int volume)
+: chunk(chunk_, Mix_FreeChunk), channel_playing(-1), singly(single_play)
+{
+    if ( nullptr != chunk.get() ) {
         Mix_VolumeChunk(chunk.get(), volume);
     }
 }
@@ -93,3 +108,251 @@ void audio_sample_t::set_volume(int volume) {
         Mix_VolumeChunk(chunk.get(), volume);
     }
 }
+
+//
+// audio_loader_t
+//
+
+static constexpr const bool DEBUG_LOADER = false;
+
+/** Header of a decoded PCM cache file, followed by `len` bytes of samples in the mixer format. */
+struct pcm_cache_header_t {
+    char magic[4];
+    uint32_t version;
+    int32_t frequency;
+    uint32_t format;
+    int32_t channels;
+    uint64_t src_size;
+    int64_t src_mtime;
+    uint32_t len;
+};
+static constexpr const char pcm_cache_magic[4] = { 'P', 'C', 'M', 'C' };
+static constexpr const uint32_t pcm_cache_version = 1;
+
+static std::string pcm_cache_name(const std::string& cache_dir, const std::string& fname) noexcept {
+    const size_t slash = fname.find_last_of('/');
+    return cache_dir + "/" + ( std::string::npos == slash ? fname : fname.substr(slash+1) ) + ".pcm";
+}
+
+/** Fills the header with the current mixer format and the source file attributes, returns false if the source is not accessible. */
+static bool pcm_cache_header(const std::string& fname, pcm_cache_header_t& h) noexcept {
+    struct stat st;
+    if( 0 != stat(fname.c_str(), &st) ) {
+        return false;
+    }
+    int frequency = 0, channels = 0;
+    Uint16 format = 0;
+    if( 0 == Mix_QuerySpec(&frequency, &format, &channels) ) {
+        return false;
+    }
+    bzero(&h, sizeof(h));
+    memcpy(h.magic, pcm_cache_magic, sizeof(h.magic));
+    h.version = pcm_cache_version;
+    h.frequency = frequency;
+    h.format = format;
+    h.channels = channels;
+    h.src_size = (uint64_t)st.st_size;
+    h.src_mtime = (int64_t)st.st_mtime;
+    return true;
+}
+
+static Mix_Chunk* pcm_cache_read(const std::string& cache_fname, const pcm_cache_header_t& expected) noexcept {
+    FILE* f = fopen(cache_fname.c_str(), "rb");
+    if( nullptr == f ) {
+        return nullptr;
+    }
+    pcm_cache_header_t h;
+    Mix_Chunk* res = nullptr;
+    if( 1 == fread(&h, sizeof(h), 1, f) && 0 < h.len ) {
+        const uint32_t len = h.len;
+        h.len = 0;
+        if( 0 == memcmp(&h, &expected, sizeof(h)) ) {
+            Uint8* buf = (Uint8*)SDL_malloc(len);
+            if( nullptr != buf && 1 == fread(buf, len, 1, f) ) {
+                res = Mix_QuickLoad_RAW(buf, len);
+            }
+            if( nullptr != res ) {
+                res->allocated = 1; // Mix_FreeChunk() releases buf
+            } else {
+                SDL_free(buf);
+            }
+        }
+    }
+    fclose(f);
+    return res;
+}
+
+static void pcm_cache_write(const std::string& cache_fname, const pcm_cache_header_t& header, const Mix_Chunk* chunk) noexcept {
+    // written to a temporary file and renamed, so concurrent launches never read a partial cache file
+    const std::string tmp_fname = cache_fname + ".tmp." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    FILE* f = fopen(tmp_fname.c_str(), "wb");
+    if( nullptr == f ) {
+        log_printf("audio_loader: Cannot write cache '%s'\n", tmp_fname.c_str());
+        return;
+    }
+    pcm_cache_header_t h = header;
+    h.len = chunk->alen;
+    const bool ok = 1 == fwrite(&h, sizeof(h), 1, f) && 1 == fwrite(chunk->abuf, chunk->alen, 1, f);
+    if( 0 != fclose(f) || !ok || 0 != rename(tmp_fname.c_str(), cache_fname.c_str()) ) {
+        log_printf("audio_loader: Cannot write cache '%s'\n", cache_fname.c_str());
+        remove(tmp_fname.c_str());
+    }
+}
+
+audio_loader_t::audio_loader_t(std::vector<clip_t> clips_, const std::string& cache_dir_)
+: clips(std::move(clips_)), cache_dir(cache_dir_), chunks(clips.size(), nullptr), errors(clips.size()), next_clip(0), t0(getCurrentMilliseconds())
+{
+    if( cache_dir.size() > 0 && 0 != mkdir(cache_dir.c_str(), 0755) && EEXIST != errno ) {
+        log_printf("audio_loader: Cannot create cache directory '%s': %s\n", cache_dir.c_str(), strerror(errno));
+        cache_dir.clear();
+    }
+    const size_t count = std::min<size_t>(clips.size(), std::max(1u, std::thread::hardware_concurrency()));
+    for(size_t i=0; i<count; ++i) {
+        workers.emplace_back(&audio_loader_t::run, this);
+    }
+}
+
+audio_loader_t::~audio_loader_t() noexcept {
+    join();
+    for(Mix_Chunk* c : chunks) {
+        if( nullptr != c ) {
+            Mix_FreeChunk(c);
+        }
+    }
+}
+
+void audio_loader_t::join() noexcept {
+    for(std::thread& w : workers) {
+        w.join();
+    }
+    workers.clear();
+}
+
+void audio_loader_t::run() noexcept {
+    for(size_t i = next_clip++; i < clips.size(); i = next_clip++) {
+        chunks[i] = load(clips[i], errors[i]);
+    }
+}
+
+Mix_Chunk* audio_loader_t::load(const clip_t& clip, std::string& error) noexcept {
+    const uint64_t t1 = getCurrentMilliseconds();
+    pcm_cache_header_t header;
+    const bool use_cache = cache_dir.size() > 0 && pcm_cache_header(clip.fname, header);
+    const std::string cache_fname = use_cache ? pcm_cache_name(cache_dir, clip.fname) : "";
+    Mix_Chunk* res = use_cache ? pcm_cache_read(cache_fname, header) : nullptr;
+    const bool cached = nullptr != res;
+    if( !cached ) {
+        {
+            // SDL_mixer's decoders and SDL_RWops are not documented thread-safe, hence decode one clip at a time,
+            // while the cache files are still read and written in parallel.
+            static std::mutex decode_mtx;
+            const std::lock_guard<std::mutex> lock(decode_mtx);
+            res = Mix_LoadWAV(clip.fname.c_str());
+            if( nullptr == res ) {
+                error = SDL_GetError(); // thread local
+            }
+        }
+        if( nullptr != res && use_cache ) {
+            pcm_cache_write(cache_fname, header, res);
+        }
+    }
+    if( DEBUG_LOADER ) {
+        log_printf("audio_loader: '%s' %s in %" PRIu64 " ms\n", clip.fname.c_str(),
+                cached ? "cached" : "decoded", getCurrentMilliseconds() - t1);
+    }
+    return res;
+}
+
+void audio_loader_t::take(std::vector<std::shared_ptr<audio_sample_t>>& dest) noexcept {
+    join();
+    for(size_t i=0; i<clips.size(); ++i) {
+        if( nullptr == chunks[i] ) {
+            log_printf("Mix_LoadWAV: Load '%s' Error: %s\n", clips[i].fname.c_str(), errors[i].c_str());
+        }
+        dest.push_back( std::make_shared<audio_sample_t>(chunks[i], clips[i].single_play) );
+        chunks[i] = nullptr;
+    }
+    log_printf("audio_loader: %zu clips ready after %" PRIu64 " ms\n", clips.size(), getCurrentMilliseconds() - t0);
+}
+
+//
+// audio_queue_t
+//
+
+audio_queue_t::audio_queue_t(std::vector<std::shared_ptr<audio_sample_t>>& samples_)
+: samples(samples_), last_posted(samples.size(), stop_cmd), pending(samples.size()), running(true)
+{
+    worker = std::thread(&audio_queue_t::run, this);
+}
+
+void audio_queue_t::stop() noexcept {
+    if( running.exchange(false) ) {
+        cv_wakeup.notify_one();
+        worker.join();
+    }
+}
+
+void audio_queue_t::post(const command_t& c) noexcept {
+    if( 0 > c.sample || (size_t)c.sample >= samples.size() || !samples[c.sample]->is_valid() ) {
+        return;
+    }
+    int& last = last_posted[c.sample];
+    if( c.loops == last && ( stop_cmd == c.loops || ( 0 == c.loops && samples[c.sample]->is_single_play() ) ) ) {
+        return; // still stopped or still looping
+    }
+    if( !ring.push(c) ) {
+        log_printf("audio queue: Dropped command %d for sample %d, queue full\n", c.loops, c.sample);
+        return;
+    }
+    last = c.loops;
+    // wakes up the audio thread without locking, a missed wakeup is caught by its timed wait
+    cv_wakeup.notify_one();
+}
+
+void audio_queue_t::run() noexcept {
+    while( running ) {
+        {
+            std::unique_lock<std::mutex> lock(mtx_wakeup);
+            cv_wakeup.wait_for(lock, std::chrono::milliseconds(10), [&]{ return !running || 0 < ring.size(); });
+        }
+        drain();
+    }
+    drain();
+}
+
+void audio_queue_t::drain() noexcept {
+    bool any = false;
+    command_t c;
+    while( ring.pop(c) ) {
+        pending_t& p = pending[c.sample];
+        if( stop_cmd == c.loops ) {
+            p.stop = true;
+            p.plays.clear();
+        } else {
+            p.plays.push_back(c.loops);
+        }
+        any = true;
+    }
+    if( !any ) {
+        return;
+    }
+    for(size_t i=0; i<pending.size(); ++i) {
+        pending_t& p = pending[i];
+        audio_sample_t& s = *samples[i];
+        if( p.stop ) {
+            s.stop();
+        }
+        if( s.is_single_play() ) {
+            // further plays are ignored while the first one is playing
+            if( p.plays.size() > 0 ) {
+                s.play(p.plays[0]);
+            }
+        } else {
+            for(const int loops : p.plays) {
+                s.play(loops);
+            }
+        }
+        p.stop = false;
+        p.plays.clear();
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ * Author: Sven Gothel <sgothel@jausoft.com> and Svenson Han Gothel
+ * Copyright (c) 2022 Gothel Software e.K.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <pacman/recorder.hpp>
+#include <pacman/utils.hpp>
+
+#include <cstring>
+
+/**
+ * Converts a delta stream recorded via `pacman -record_delta` into a YUV4MPEG2 video stream,
+ * repeating elided duplicate and dropped frames to keep the original timing.
+ */
+int main(int argc, char *argv[])
+{
+    if( 3 > argc ) {
+        fprintf(stderr, "Usage: %s <delta-file> <y4m-file|->\n", argv[0]);
+        return 1;
+    }
+    delta_reader_t in(argv[1]);
+    if( !in.is_open() ) {
+        return 1;
+    }
+    y4m_writer_t out(argv[2], in.fps());
+    if( !out.is_open() ) {
+        return 1;
+    }
+    SDL_Surface* frame = SDL_CreateRGBSurfaceWithFormat(0, in.width(), in.height(), 32, SDL_PIXELFORMAT_ARGB8888);
+    if( nullptr == frame ) {
+        log_printf("Error creating %d x %d frame: %s\n", in.width(), in.height(), SDL_GetError());
+        return 1;
+    }
+    uint64_t stored = 0;
+    uint64_t written = 0;
+    uint64_t next_frame_no = 0;
+    while( in.next() ) {
+        if( 0 < stored ) {
+            for(; next_frame_no < in.frame_no(); ++next_frame_no, ++written) {
+                out.write(frame, "", next_frame_no);
+            }
+        }
+        for(int y=0; y<in.height(); ++y) {
+            memcpy(static_cast<uint8_t*>(frame->pixels) + (size_t)y * frame->pitch, in.pixels() + (size_t)y * in.width(), in.width() * sizeof(uint32_t));
+        }
+        out.write(frame, "", in.frame_no());
+        next_frame_no = in.frame_no() + 1;
+        ++stored;
+        ++written;
+    }
+    log_printf("%s: %" PRIu64 " stored frames -> %" PRIu64 " frames, %s\n", argv[1], stored, written, out.toString().c_str());
+    SDL_FreeSurface(frame);
+    return in.has_error() ? 1 : 0;
+}
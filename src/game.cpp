@@ -27,11 +27,21 @@
 #include <pacman/maze.hpp>
 #include <pacman/game.hpp>
 #include <pacman/globals.hpp>
+#include <pacman/recorder.hpp>
+#include <pacman/hot_reload.hpp>
 
 #include <limits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <deque>
+#include <fstream>
+#include <sstream>
 
 #include <cstdio>
 #include <time.h>
+#include <sys/resource.h>
 
 //
 // globals across modules 'globals.hpp'
@@ -40,13 +50,18 @@
 static int win_pixel_width_ = 0;
 static int win_pixel_height_ = 0;
 static int win_pixel_scale_ = 1;
+static viewport_t win_viewport_;
 int win_pixel_width() noexcept { return win_pixel_width_; }
 int win_pixel_height() noexcept { return win_pixel_height_; }
 int win_pixel_scale() noexcept{ return win_pixel_scale_; }
+const viewport_t& win_viewport() noexcept { return win_viewport_; }
 
-static int frames_per_sec = 0;
+static int frames_per_sec = 60;
 int get_frames_per_sec() noexcept { return frames_per_sec; }
 
+/** render frames per second, i.e. the monitor refresh rate or enforced via `-fps` */
+static int render_frames_per_sec = 0;
+
 static TTF_Font* font_ttf_ = nullptr;
 TTF_Font* font_ttf() noexcept { return font_ttf_; }
 
@@ -59,20 +74,33 @@ int get_current_level() noexcept { return current_level; }
 
 std::unique_ptr<maze_t> global_maze;
 std::shared_ptr<global_tex_t> global_tex;
-static std::vector<ghost_ref> ghosts_;
+static inplace_array_t<ghost_t> ghosts_;
 pacman_ref pacman;
 
-std::vector<ghost_ref>& ghosts() noexcept { return ghosts_; }
+inplace_array_t<ghost_t>& ghosts() noexcept { return ghosts_; }
 
 ghost_ref ghost(const ghost_t::personality_t id) noexcept {
     const int idx = ghost_t::number(id);
     if( 0 <= idx && (size_t)idx < ghosts_.size() ) {
-        return ghosts_[ ghost_t::number(id)];
+        return &ghosts_[ idx ];
     } else {
         return nullptr;
     }
 }
 std::vector<audio_sample_ref> audio_samples;
+static std::unique_ptr<audio_queue_t> audio_queue;
+
+void audio_play(const audio_clip_t clip, const int loops) noexcept {
+    if( nullptr != audio_queue ) {
+        audio_queue->play(number(clip), loops);
+    }
+}
+
+void audio_stop(const audio_clip_t clip) noexcept {
+    if( nullptr != audio_queue ) {
+        audio_queue->stop(number(clip));
+    }
+}
 
 static bool original_pacman_behavior = true;
 bool use_original_pacman_behavior() noexcept { return original_pacman_behavior; }
@@ -189,6 +217,122 @@ const game_level_spec_t& game_level_spec() noexcept {
     return level_spec_array[ level_to_idx( get_current_level() ) ];
 }
 
+static bool parse_fruit(const std::string& s, tile_t& dest) noexcept {
+    for(int i=number(tile_t::CHERRY); i<=number(tile_t::KEY); ++i) {
+        if( to_string( static_cast<tile_t>(i) ) == s ) {
+            dest = static_cast<tile_t>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_wave(const std::string& s, ghost_wave_t& dest) noexcept {
+    const size_t sep = s.find('/');
+    if( std::string::npos == sep ) {
+        return false;
+    }
+    const std::string chase = s.substr(sep+1);
+    dest.scatter_ms = atoi( s.substr(0, sep).c_str() );
+    dest.chase_ms = "max" == chase ? std::numeric_limits<int>::max() : atoi( chase.c_str() );
+    return 0 <= dest.scatter_ms && 0 < dest.chase_ms;
+}
+
+bool load_level_spec(const std::string& fname, std::vector<game_level_spec_t>& dest) noexcept {
+    std::ifstream file(fname);
+    if( !file.is_open() ) {
+        log_printf("Could not open level spec file: %s\n", fname.c_str());
+        return false;
+    }
+    std::map<std::string, ghost_wave_vec_t> waves;
+    std::map<std::string, ghost_pellet_counter_limit_t> limits;
+    std::vector<game_level_spec_t> spec;
+    std::string line;
+    for(int line_no=1; std::getline(file, line); ++line_no) {
+        std::istringstream in(line);
+        std::string kind, name;
+        if( !( in >> kind ) || '#' == kind[0] ) {
+            continue;
+        }
+        bool ok = false;
+        if( "wave" == kind && in >> name ) {
+            ghost_wave_vec_t& w = waves[name];
+            w.clear();
+            ghost_wave_t wave;
+            std::string s;
+            ok = true;
+            while( ok && in >> s ) {
+                ok = parse_wave(s, wave);
+                w.push_back(wave);
+            }
+            ok = ok && w.size() > 0;
+        } else if( "limit" == kind && in >> name ) {
+            ghost_pellet_counter_limit_t& l = limits[name];
+            l.assign(ghost_t::personality_count, 0);
+            ok = true;
+            for(int i=0; ok && i<ghost_t::personality_count; ++i) {
+                ok = (bool)( in >> l[i] ) && 0 <= l[i];
+            }
+        } else if( "level" == kind ) {
+            game_level_spec_t l;
+            std::string symbol, wave_name, limit_name;
+            ok = in >> symbol >> l.bonus_points >> l.pacman_speed >> l.pacman_speed_dots >> l.pacman_powered_speed >> l.pacman_powered_speed_dots
+                    >> l.ghost_speed >> l.ghost_speed_tunnel >> l.ghost_fright_speed >> l.fright_time_ms >> l.fright_flash_count
+                    >> l.elroy1_dots_left >> l.elroy1_speed >> l.elroy2_dots_left >> l.elroy2_speed >> wave_name >> limit_name >> l.ghost_max_home_time_ms &&
+                 parse_fruit(symbol, l.symbol) && waves.count(wave_name) && limits.count(limit_name);
+            if( ok ) {
+                l.ghost_waves = waves[wave_name];
+                l.ghost_pellet_counter_limit = limits[limit_name];
+                spec.push_back(l);
+            }
+        }
+        if( !ok ) {
+            log_printf("level spec error: %s:%d: %s\n", fname.c_str(), line_no, line.c_str());
+            return false;
+        }
+    }
+    if( spec.empty() ) {
+        log_printf("level spec error: %s: no level\n", fname.c_str());
+        return false;
+    }
+    dest = std::move(spec);
+    return true;
+}
+
+void set_level_spec(std::vector<game_level_spec_t>&& spec) noexcept {
+    if( spec.size() > 0 ) {
+        level_spec_array = std::move(spec);
+    }
+}
+
+/** Returns the FNV-1a checksum of all values of the current level specification, see set_level_spec(). */
+static uint32_t level_spec_checksum() noexcept {
+    uint32_t h = 0x811c9dc5U;
+    auto add = [&h](const void* data, const size_t count) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        for(size_t i=0; i<count; ++i) {
+            h = ( h ^ p[i] ) * 0x01000193U;
+        }
+    };
+    for(const game_level_spec_t& l : level_spec_array) {
+        const int32_t ints[] = { number(l.symbol), l.bonus_points, l.fright_time_ms, l.fright_flash_count,
+                                 l.elroy1_dots_left, l.elroy2_dots_left, l.ghost_max_home_time_ms, (int32_t)l.ghost_waves.size() };
+        const float floats[] = { l.pacman_speed, l.pacman_speed_dots, l.pacman_powered_speed, l.pacman_powered_speed_dots,
+                                 l.ghost_speed, l.ghost_speed_tunnel, l.ghost_fright_speed, l.elroy1_speed, l.elroy2_speed };
+        add(ints, sizeof(ints));
+        add(floats, sizeof(floats));
+        for(const ghost_wave_t& w : l.ghost_waves) {
+            const int32_t wave[] = { w.scatter_ms, w.chase_ms };
+            add(wave, sizeof(wave));
+        }
+        for(const int v : l.ghost_pellet_counter_limit) {
+            const int32_t limit = v;
+            add(&limit, sizeof(limit));
+        }
+    }
+    return h;
+}
+
 const ghost_wave_t& get_ghost_wave(const int level, const int phase_idx) noexcept {
     const ghost_wave_vec_t& waves = game_level_spec(level).ghost_waves;
     const int idx = 0 <= phase_idx && (size_t)phase_idx < waves.size() ? phase_idx : (int)waves.size()-1;
@@ -225,45 +369,31 @@ global_tex_t::global_tex_t(SDL_Renderer* rend) noexcept
 : all_images_( std::make_shared<texture_t>(rend, "media/tiles_all.png") ),
   atex_pellet_power( "PP", rend, 250, all_images_, 0, 0, 14, 14, { { 1*14, 0 }, { -1, -1} })
 {
-    add_sub_textures(textures, rend, all_images_, 0, 0, 14, 14, {
+    add_sub_textures(textures, all_images_, 0, 0, 14, 14, {
             {  0*14, 0 }, {  1*14, 0 }, {  2*14, 0 }, {  3*14, 0 }, {  4*14, 0 }, {  5*14, 0 }, {  6*14, 0 },
             {  7*14, 0 }, {  8*14, 0 }, {  9*14, 0 }, { 10*14, 0 }, { 11*14, 0 }, { 12*14, 0 }, { 13*14, 0 },  } );
 }
 
 void global_tex_t::destroy() noexcept {
-    for(size_t i=0; i<textures.size(); ++i) {
-        textures[i]->destroy();
-    }
     textures.clear();
     all_images_->destroy();
 }
 
-std::shared_ptr<texture_t> global_tex_t::texture(const int idx) noexcept {
+tex_handle_t global_tex_t::handle(const int idx) const noexcept {
     const int idx2 = validate_texidx(idx);
-    return 0 <= idx2 ? textures[idx2] : nullptr;
-}
-std::shared_ptr<const texture_t> global_tex_t::texture(const int idx) const noexcept {
-    const int idx2 = validate_texidx(idx);
-    return 0 <= idx2 ? textures[idx2] : nullptr;
+    return 0 <= idx2 ? textures[idx2] : tex_handle_none;
 }
 
-std::shared_ptr<texture_t> global_tex_t::texture(const tile_t tile) noexcept {
+tex_handle_t global_tex_t::handle(const tile_t tile) const noexcept {
     const int idx = tile_to_texidx(tile);
-    return 0 <= idx ? textures[idx] : nullptr;
-}
-std::shared_ptr<const texture_t> global_tex_t::texture(const tile_t tile) const noexcept {
-    const int idx = tile_to_texidx(tile);
-    return 0 <= idx ? textures[idx] : nullptr;
+    return 0 <= idx ? textures[idx] : tex_handle_none;
 }
 
-void global_tex_t::draw_tile(const tile_t tile, SDL_Renderer* rend, const float x, const float y) noexcept {
+void global_tex_t::draw_tile(const tile_t tile, SDL_Renderer* rend, const float x, const float y, const tex_handle_t pellet_power_tex) const noexcept {
     if( tile_t::PELLET_POWER == tile ) {
-        atex_pellet_power.draw2(rend, x, y);
+        get_tex_region(pellet_power_tex).draw2_f(rend, x, y);
     } else {
-        std::shared_ptr<texture_t> tex = texture(tile);
-        if( nullptr != tex ) {
-            tex->draw2_f(rend, x, y);
-        }
+        texture(tile).draw2_f(rend, x, y);
     }
 }
 
@@ -280,7 +410,10 @@ static void on_window_resized(SDL_Renderer* rend, const int win_width_l, const i
 
     float sx = win_pixel_width() / global_maze->pixel_width();
     float sy = win_pixel_height() / global_maze->pixel_height();
-    win_pixel_scale_ = static_cast<int>( std::round( std::fmin<float>(sx, sy) ) );
+    win_pixel_scale_ = std::max( 1, static_cast<int>( std::round( std::fmin<float>(sx, sy) ) ) );
+    win_viewport_.reset(win_pixel_width(), win_pixel_height(), global_maze->width(), global_maze->height(),
+                        global_maze->ppt_x(), global_maze->ppt_y(), win_pixel_scale());
+    rescale_tex_atlases(rend, win_pixel_scale());
 
     if( nullptr != font_ttf() ) {
         TTF_CloseFont(font_ttf());
@@ -293,15 +426,16 @@ static void on_window_resized(SDL_Renderer* rend, const int win_width_l, const i
         font_ttf_ = TTF_OpenFont(fontfilename.c_str(), font_height);
     }
     log_printf("Window Resized: %d x %d pixel ( %d x %d logical ) @ %d hz\n",
-            win_pixel_width(), win_pixel_height(), win_width_l, win_height_l, get_frames_per_sec());
-    log_printf("Pixel scale: %f x %f -> %d, font[ok %d, height %d]\n", sx, sy, win_pixel_scale(), nullptr!=font_ttf(), font_height);
+            win_pixel_width(), win_pixel_height(), win_width_l, win_height_l, render_frames_per_sec);
+    log_printf("Pixel scale: %f x %f -> %d, font[ok %d, height %d], %s\n", sx, sy, win_pixel_scale(), nullptr!=font_ttf(), font_height, win_viewport().toString().c_str());
 }
 
 static std::string get_usage(const std::string& exename) noexcept {
     // TODO: Keep in sync with README.md
-    return "Usage: "+exename+" [-2p] [-audio] [-pixqual <int>] [-no_vsync] [-fps <int>] [-speed <int>] [-wwidth <int>] [-wheight <int>] "+
+    return "Usage: "+exename+" [-2p] [-audio] [-audio_cache <dir>] [-pixqual <int>] [-no_vsync] [-fps <int>] [-tps <int>] [-speed <int>] [-wwidth <int>] [-wheight <int>] "+
               "[-show_fps] [-show_modes] [-show_moves] [-show_targets] [-show_debug_gfx] [-show_all] "+
-              "[-no_ghosts] [-invincible] [-bugfix] [-decision_on_spot] [-dist_manhatten] [-level <int>] [-record <basename-of-bmp-files>]";
+              "[-no_ghosts] [-invincible] [-bugfix] [-decision_on_spot] [-dist_manhatten] [-level <int>] [-record <basename-of-bmp-files>] [-record_y4m <file|->] [-record_delta <file>] [-record_policy block|drop|degrade] [-record_format bmp|png|qoi] [-headless] [-frames <int>] "+
+              "[-record_input <file>] [-replay_input <file>] [-maze <file>] [-stress] [-level_spec <file>] [-hot_reload] [-ghosts <int>]";
 }
 
 //
@@ -336,24 +470,91 @@ static constexpr int number(const game_mode_duration_t item) noexcept {
     return static_cast<int>(item);
 }
 static int game_mode_ms_left = -1;
+/** True if the level start lasts as long as the intro sound, a simulation option independent of audio output, see input_log_options_t */
+static bool level_start_sound = false;
+/** True after a level start until recorded as input_restart_t by the simulation */
+static bool level_restarted = false;
 static game_mode_t game_mode = game_mode_t::PAUSE;
 static game_mode_t game_mode_last = game_mode_t::PAUSE;
 
+//
+// hot reload, see `-hot_reload`
+//
+
+static std::unique_ptr<hot_reload_t> hot_reload;
+/** True while the simulation runs on its own thread, i.e. the render thread performs the swap */
+static std::atomic<bool> hot_swap_threaded(false);
+static std::atomic<bool> hot_swap_requested(false);
+static std::mutex hot_swap_mtx;
+static std::condition_variable hot_swap_cv;
+
+/** Swaps in the pending rebuilt maze and level specification, requires neither simulation nor rendering to run. */
+static void hot_swap_apply() noexcept {
+    std::unique_ptr<maze_t> maze = hot_reload->take_maze();
+    if( nullptr != maze ) {
+        if( global_maze->same_layout(*maze) ) {
+            maze->inherit_modcount(*global_maze);
+            global_maze = std::move(maze);
+            log_printf("Hot reload: maze swapped: %s\n", global_maze->toString().c_str());
+        } else {
+            log_printf("Hot reload: maze rejected, dimension, texture or ghost house changed, restart required\n");
+        }
+    }
+    std::vector<game_level_spec_t> spec;
+    if( hot_reload->take_level_spec(spec) ) {
+        const size_t count = spec.size();
+        set_level_spec( std::move(spec) );
+        log_printf("Hot reload: level spec swapped, %zu levels\n", count);
+    }
+}
+
+/**
+ * Swaps in a pending hot reload at the level boundary, called by the simulation.
+ *
+ * If the simulation runs on its own thread, it waits while the render thread performs the swap
+ * via hot_swap_service(), hence neither thread accesses global_maze meanwhile.
+ */
+static void hot_swap_at_level_boundary() noexcept {
+    if( nullptr == hot_reload || !hot_reload->has_pending() ) {
+        return;
+    }
+    if( !hot_swap_threaded ) {
+        hot_swap_apply();
+        return;
+    }
+    std::unique_lock<std::mutex> lock(hot_swap_mtx);
+    hot_swap_requested = true;
+    while( hot_swap_requested && hot_swap_threaded ) {
+        hot_swap_cv.wait_for(lock, std::chrono::milliseconds(10));
+    }
+    hot_swap_requested = false;
+}
+
+/** Performs the swap requested by the simulation thread, called by the render thread between frames. */
+static void hot_swap_service() noexcept {
+    if( hot_swap_requested ) {
+        std::lock_guard<std::mutex> lock(hot_swap_mtx);
+        if( hot_swap_requested ) {
+            hot_swap_apply();
+            hot_swap_requested = false;
+        }
+        hot_swap_cv.notify_all();
+    }
+}
+
 static void set_game_mode(const game_mode_t m, const int caller) noexcept {
     const game_mode_t old_mode = game_mode;
     const int old_level = current_level;
     switch( m ) {
         case game_mode_t::NEXT_LEVEL:
             ++current_level;
+            level_restarted = true;
+            hot_swap_at_level_boundary();
             global_maze->reset();
             pacman->set_mode( pacman_t::mode_t::LEVEL_SETUP );
             game_mode = game_mode_t::START;
-            if( audio_samples[ number( audio_clip_t::INTRO ) ]->is_valid() ) {
-                audio_samples[ number( audio_clip_t::INTRO ) ]->play();
-                game_mode_ms_left = number( game_mode_duration_t::LEVEL_START_SOUND );
-            } else {
-                game_mode_ms_left = number( game_mode_duration_t::LEVEL_START );
-            }
+            audio_play( audio_clip_t::INTRO );
+            game_mode_ms_left = number( level_start_sound ? game_mode_duration_t::LEVEL_START_SOUND : game_mode_duration_t::LEVEL_START );
             break;
         case game_mode_t::START:
             pacman->set_mode( pacman_t::mode_t::LEVEL_SETUP );
@@ -378,6 +579,799 @@ static void set_game_mode(const game_mode_t m, const int caller) noexcept {
             caller, to_string(old_mode).c_str(), to_string(game_mode).c_str(), game_mode_ms_left, old_level, current_level);
 }
 
+//
+// simulation thread
+//
+
+/** Input commands posted by the event and render thread to the simulation thread */
+enum class game_cmd_t : uint8_t {
+    PACMAN_DIR,
+    BLINKY_DIR,
+    PAUSE,
+    RESET,
+    WINDOW_SHOWN,
+    DUMP_REPLAY
+};
+struct game_input_t {
+    game_cmd_t cmd;
+    direction_t dir;
+    bool on;
+};
+static spsc_ring_t<game_input_t, 64> game_input;
+static triple_buffer_t<frame_snapshot_t> frame_snapshots;
+static std::atomic<bool> sim_running(false);
+
+static void post_input(const game_cmd_t cmd, const direction_t dir, const bool on) noexcept {
+    if( !game_input.push( game_input_t { cmd, dir, on } ) ) {
+        log_printf("game input: Dropped command %d, queue full\n", (int)cmd);
+    }
+}
+
+/**
+ * Game input log for deterministic replay, owned by the simulation thread.
+ *
+ * The log starts with an `options ...` line holding the simulation affecting options, see input_log_options_t.
+ * Each game input applied is stored with the number of the simulation tick it has been applied to,
+ * one line `<tick> <cmd> <dir> <on>` each, terminated by a line `<tick> end` holding the last tick.
+ * An optional line `<tick> from` lets offline rendering start at the given tick.
+ * An optional `restart ...` line lets the log start at a level restart point, see input_restart_t.
+ * WINDOW_SHOWN and DUMP_REPLAY are not logged, as they don't alter the game state.
+ */
+struct input_log_entry_t {
+    uint64_t tick;
+    game_input_t in;
+};
+
+/**
+ * Simulation affecting options of an input log, i.e. its `options` line.
+ *
+ * A replay applies the recorded options and rejects a different maze or level specification by their checksum,
+ * see maze_t::checksum() and level_spec_checksum().
+ */
+struct input_log_options_t {
+    int level = 1;
+    bool two_players = false;
+    bool bugfix = false;
+    bool decision_on_spot = false;
+    bool dist_manhatten = false;
+    int tps = 60;
+    float speed = 10;
+    bool no_ghosts = false;
+    bool invincible = false;
+    int ghosts = ghost_t::personality_count;
+    uint32_t maze_checksum = 0;
+    uint32_t level_spec_checksum = 0;
+    /** see level_start_sound */
+    bool intro_sound = false;
+};
+/** Options of this session, written to each input log */
+static input_log_options_t input_log_options;
+
+/**
+ * Level restart point of an input log, i.e. the game state at a level start, see set_game_mode().
+ *
+ * A level start drops the previous level's actor state,
+ * hence the simulation continues from here given the level, score, fruit PRNG state and the held directions.
+ * An input log may start at a restart point via its `restart ...` line, its ticks counted from the restart.
+ */
+struct input_restart_t {
+    /** first simulation tick after the restart */
+    uint64_t tick;
+    /** input_history sequence number of the first input after the restart */
+    uint64_t seq;
+    int level;
+    uint64_t score;
+    uint32_t fruit_rng;
+    direction_t pacman_dir;
+    bool set_dir_1;
+    direction_t blinky_dir;
+    bool set_dir_2;
+    uint32_t maze_checksum;
+    uint32_t level_spec_checksum;
+};
+static FILE* input_log_out = nullptr;
+static std::vector<input_log_entry_t> input_replay;
+static size_t input_replay_pos = 0;
+static uint64_t input_replay_end = 0;
+static uint64_t input_replay_from = 0;
+static bool input_replay_has_restart = false;
+static input_restart_t input_replay_restart;
+static std::atomic<bool> input_replay_done(true);
+
+/**
+ * Fixed-size in-memory ring of the latest inputs for the instant replay dump via `F11`,
+ * the input of sequence number `seq` stored at `seq % input_history_capacity`.
+ *
+ * Along with the level restart points covering the last instant_replay_sec seconds,
+ * the dump starts at the latest restart before and renders from the tick instant_replay_sec seconds ago.
+ * Being deterministic, the replay from the restart reproduces the game state without storing it.
+ */
+static constexpr const size_t input_history_capacity = 1 << 16;
+static constexpr const int instant_replay_sec = 30;
+static std::vector<input_log_entry_t> input_history;
+static uint64_t input_history_seq = 0;
+static std::deque<input_restart_t> input_restarts;
+static std::thread input_dump_thread;
+static std::atomic<bool> input_dump_busy(false);
+static int input_dump_counter = 0;
+
+static void print_input_log_entry(FILE* out, const input_log_entry_t& e) noexcept {
+    fprintf(out, "%" PRIu64 " %d %d %d\n", e.tick, (int)e.in.cmd, (int)e.in.dir, (int)e.in.on);
+}
+
+static void print_input_log_options(FILE* out, const input_log_options_t& o) noexcept {
+    fprintf(out, "options level %d 2p %d bugfix %d decision_on_spot %d dist_manhatten %d tps %d speed %.9g no_ghosts %d invincible %d ghosts %d intro_sound %d maze %08x level_spec %08x\n",
+            o.level, o.two_players, o.bugfix, o.decision_on_spot, o.dist_manhatten, o.tps, o.speed,
+            o.no_ghosts, o.invincible, o.ghosts, o.intro_sound, o.maze_checksum, o.level_spec_checksum);
+}
+
+static bool parse_input_log_options(const char* line, input_log_options_t& o) noexcept {
+    int two_players, bugfix, decision_on_spot, dist_manhatten, no_ghosts, invincible, intro_sound;
+    if( 13 != sscanf(line, "options level %d 2p %d bugfix %d decision_on_spot %d dist_manhatten %d tps %d speed %f no_ghosts %d invincible %d ghosts %d intro_sound %d maze %x level_spec %x",
+                     &o.level, &two_players, &bugfix, &decision_on_spot, &dist_manhatten, &o.tps, &o.speed,
+                     &no_ghosts, &invincible, &o.ghosts, &intro_sound, &o.maze_checksum, &o.level_spec_checksum) )
+    {
+        return false;
+    }
+    o.two_players = 0 != two_players;
+    o.bugfix = 0 != bugfix;
+    o.decision_on_spot = 0 != decision_on_spot;
+    o.dist_manhatten = 0 != dist_manhatten;
+    o.no_ghosts = 0 != no_ghosts;
+    o.invincible = 0 != invincible;
+    o.intro_sound = 0 != intro_sound;
+    return 1 <= o.tps && 0 < o.speed && 0 <= o.ghosts && o.ghosts <= ghost_t::max_ghost_count;
+}
+
+static void print_input_log_restart(FILE* out, const input_restart_t& r) noexcept {
+    fprintf(out, "restart level %d score %" PRIu64 " fruit_rng %u pacman_dir %d %d blinky_dir %d %d\n",
+            r.level, r.score, r.fruit_rng, (int)r.pacman_dir, (int)r.set_dir_1, (int)r.blinky_dir, (int)r.set_dir_2);
+}
+
+static bool parse_input_log_restart(const char* line, input_restart_t& r) noexcept {
+    int pacman_dir, set_dir_1, blinky_dir, set_dir_2;
+    if( 7 != sscanf(line, "restart level %d score %" SCNu64 " fruit_rng %u pacman_dir %d %d blinky_dir %d %d",
+                    &r.level, &r.score, &r.fruit_rng, &pacman_dir, &set_dir_1, &blinky_dir, &set_dir_2) )
+    {
+        return false;
+    }
+    r.tick = 1;
+    r.seq = 0;
+    r.pacman_dir = static_cast<direction_t>(pacman_dir);
+    r.set_dir_1 = 0 != set_dir_1;
+    r.blinky_dir = static_cast<direction_t>(blinky_dir);
+    r.set_dir_2 = 0 != set_dir_2;
+    return 1 <= r.level;
+}
+
+static void write_input_log(const std::string& fname, const input_log_options_t& options, const input_restart_t& restart,
+                            const std::vector<input_log_entry_t>& entries, const uint64_t from_tick, const uint64_t end_tick) noexcept
+{
+    FILE* out = fopen(fname.c_str(), "w");
+    if( nullptr == out ) {
+        log_printf("input log: Error opening %s\n", fname.c_str());
+        return;
+    }
+    print_input_log_options(out, options);
+    print_input_log_restart(out, restart);
+    for(const input_log_entry_t& e : entries) {
+        print_input_log_entry(out, e);
+    }
+    fprintf(out, "%" PRIu64 " from\n", from_tick);
+    fprintf(out, "%" PRIu64 " end\n", end_tick);
+    fclose(out);
+    log_printf("input log: Written %s, %zu inputs, ticks [%" PRIu64 "..%" PRIu64 "]\n", fname.c_str(), entries.size(), from_tick, end_tick);
+}
+
+/**
+ * Writes the input_history since the latest level restart before the last instant_replay_sec seconds in the background,
+ * ticks counted from the restart. Skipped while the previous dump is still being written. Simulation thread only.
+ */
+static void dump_input_history(const uint64_t end_tick) noexcept {
+    if( input_dump_busy ) {
+        log_printf("input log: Instant replay skipped, previous one still being written\n");
+        return;
+    }
+    if( input_dump_thread.joinable() ) {
+        input_dump_thread.join(); // already completed
+    }
+    const uint64_t span = (uint64_t)instant_replay_sec * (uint64_t)get_frames_per_sec();
+    const uint64_t from_tick = end_tick > span ? end_tick - span : 0;
+    const uint64_t oldest_seq = input_history_seq > input_history_capacity ? input_history_seq - input_history_capacity : 0;
+
+    // latest restart at from_tick with all its inputs retained, otherwise the oldest one retained
+    const input_restart_t* r = nullptr;
+    for(const input_restart_t& i : input_restarts) {
+        if( i.seq >= oldest_seq && ( nullptr == r || i.tick <= from_tick ) ) {
+            r = &i;
+        }
+    }
+    if( nullptr == r ) {
+        log_printf("input log: Instant replay unavailable, the inputs of this level exceed the history\n");
+        return;
+    }
+    if( r->tick > from_tick && 0 < from_tick ) {
+        log_printf("input log: Instant replay shortened to the level start at tick %" PRIu64 "\n", r->tick);
+    }
+    std::vector<input_log_entry_t> entries;
+    entries.reserve(input_history_seq - r->seq);
+    for(uint64_t seq = r->seq; seq < input_history_seq; ++seq) {
+        input_log_entry_t e = input_history[seq % input_history_capacity];
+        e.tick = e.tick - r->tick + 1;
+        entries.push_back(e);
+    }
+    input_log_options_t options = input_log_options;
+    options.maze_checksum = r->maze_checksum;
+    options.level_spec_checksum = r->level_spec_checksum;
+
+    std::string fname(128, '\0');
+    const int written = std::snprintf(&fname[0], fname.size(), "puckman-replay-%4.4d.input", input_dump_counter++);
+    fname.resize(written);
+    const uint64_t from = from_tick >= r->tick ? from_tick - r->tick + 1 : 0;
+    const uint64_t end = end_tick - r->tick + 1;
+    input_dump_busy = true;
+    input_dump_thread = std::thread([fname, options, restart=*r, entries=std::move(entries), from, end]() {
+        write_input_log(fname, options, restart, entries, from, end);
+        input_dump_busy = false;
+    });
+}
+
+static bool open_input_log(const std::string& fname) noexcept {
+    input_log_out = fopen(fname.c_str(), "w");
+    if( nullptr == input_log_out ) {
+        log_printf("input log: Error opening %s\n", fname.c_str());
+        return false;
+    }
+    print_input_log_options(input_log_out, input_log_options);
+    return true;
+}
+
+static void close_input_log(const uint64_t last_tick) noexcept {
+    if( nullptr != input_log_out ) {
+        fprintf(input_log_out, "%" PRIu64 " end\n", last_tick);
+        fclose(input_log_out);
+        input_log_out = nullptr;
+    }
+}
+
+/** Loads the given input log into input_replay and its recorded options into dest, see input_log_options_t. */
+static bool load_input_replay(const std::string& fname, input_log_options_t& dest) noexcept {
+    FILE* in = fopen(fname.c_str(), "r");
+    if( nullptr == in ) {
+        log_printf("input replay: Error opening %s\n", fname.c_str());
+        return false;
+    }
+    input_replay.clear();
+    input_replay_pos = 0;
+    input_replay_end = 0;
+    bool has_options = false;
+    char line[256];
+    while( nullptr != fgets(line, sizeof(line), in) ) {
+        uint64_t tick;
+        int cmd, dir, on;
+        char end[5];
+        if( 0 == strncmp("options ", line, 8) ) {
+            has_options = parse_input_log_options(line, dest);
+            if( !has_options ) {
+                log_printf("input replay: %s: Invalid options line: %s", fname.c_str(), line);
+                fclose(in);
+                return false;
+            }
+        } else if( 0 == strncmp("restart ", line, 8) ) {
+            input_replay_has_restart = parse_input_log_restart(line, input_replay_restart);
+            if( !input_replay_has_restart ) {
+                log_printf("input replay: %s: Invalid restart line: %s", fname.c_str(), line);
+                fclose(in);
+                return false;
+            }
+        } else if( 4 == sscanf(line, "%" SCNu64 " %d %d %d", &tick, &cmd, &dir, &on) ) {
+            input_replay.push_back( input_log_entry_t { tick, game_input_t { static_cast<game_cmd_t>(cmd), static_cast<direction_t>(dir), 0 != on } } );
+        } else if( 2 == sscanf(line, "%" SCNu64 " %4s", &tick, end) ) {
+            if( 0 == strcmp("end", end) ) {
+                input_replay_end = tick;
+            } else if( 0 == strcmp("from", end) ) {
+                input_replay_from = tick;
+            }
+        }
+    }
+    fclose(in);
+    if( !has_options ) {
+        log_printf("input replay: %s: Missing options line\n", fname.c_str());
+        return false;
+    }
+    input_replay_done = false;
+    log_printf("input replay: %s, %zu inputs, %" PRIu64 " ticks\n", fname.c_str(), input_replay.size(), input_replay_end);
+    return true;
+}
+
+static int64_t get_monotonic_ns() noexcept {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t)t.tv_sec * NanoPerOne + t.tv_nsec;
+}
+
+/** Actor positions of the last captured tick, owned by the simulation thread */
+static actor_pos_t last_pacman_pos = { 0, 0, 0, 0 };
+static std::vector<actor_pos_t> last_ghost_pos;
+
+/**
+ * Sets the previous position of the given freshly captured pos from last, if valid, and stores pos in last.
+ */
+static void carry_prev_pos(actor_pos_t& pos, actor_pos_t& last, const bool valid) noexcept {
+    if( valid ) {
+        pos.prev_x = last.x;
+        pos.prev_y = last.y;
+    }
+    last = pos;
+}
+
+/**
+ * Advances the game by one tick.
+ */
+static void sim_tick(const bool set_dir_1, const direction_t pacman_dir,
+                     const bool set_dir_2, const direction_t blinky_dir, ghost_ref blinky) noexcept
+{
+    bool game_active;
+
+    if( 0 < game_mode_ms_left ) {
+        game_mode_ms_left = std::max( 0, game_mode_ms_left - get_ms_per_frame() );
+    }
+
+    switch( game_mode ) {
+        case game_mode_t::START:
+            if( 0 == game_mode_ms_left ) {
+                set_game_mode( game_mode_t::GAME, 20 );
+                game_active = true;
+            } else {
+                game_active = false;
+            }
+            break;
+        case game_mode_t::PAUSE:
+            game_active = false;
+            break;
+        case game_mode_t::GAME:
+            if( 0 == global_maze->count( tile_t::PELLET ) && 0 == global_maze->count( tile_t::PELLET_POWER ) ) {
+                // the level restart completes this tick, see sim_take_restart()
+                set_game_mode(game_mode_t::NEXT_LEVEL, 21);
+                game_active = false;
+                break;
+            }
+        [[fallthrough]];
+        default:
+            game_active = true;
+            break;
+    }
+
+    if( game_active ) {
+        if( set_dir_1 ) {
+            pacman->set_dir(pacman_dir);
+        }
+        if( set_dir_2 && nullptr != blinky ) {
+            blinky->set_dir(blinky_dir);
+        }
+        global_tex->tick();
+        ghost_t::global_tick();
+        if( !pacman->tick() ) {
+            // pacman caught and died .. post dead animation
+            set_game_mode( game_mode_t::START, 22 );
+        }
+    }
+}
+
+/**
+ * Captures the current game state into the given recycled frame_snapshot_t.
+ */
+static void sim_capture(frame_snapshot_t& f, const uint64_t tick) noexcept {
+    f.tick = tick;
+    f.tick_ns = get_monotonic_ns();
+    f.level = current_level;
+    f.score = pacman->score();
+    f.show_ready = game_mode_t::START == game_mode;
+    f.pellets_left = global_maze->count(tile_t::PELLET);
+    f.pellets_max = global_maze->max(tile_t::PELLET);
+    f.pellet_power_tex = global_tex->pellet_power_texture();
+    if( 0 == f.tiles_modcount || f.tiles_modcount != global_maze->modcount() ) {
+        global_maze->copy_nonempty_tiles(f.tiles);
+        f.tiles_modcount = global_maze->modcount();
+    }
+    f.pacman = pacman->get_snapshot();
+    carry_prev_pos(f.pacman.pos, last_pacman_pos, 1 < tick);
+
+    ghost_t::global_snapshot(f.ghosts);
+    const bool ghosts_valid = 1 < tick && last_ghost_pos.size() == f.ghosts.size();
+    last_ghost_pos.resize(f.ghosts.size());
+    for(size_t i=0; i<f.ghosts.size(); ++i) {
+        carry_prev_pos(f.ghosts[i].pos, last_ghost_pos[i], ghosts_valid);
+    }
+}
+
+/** Simulation input state, owned by the simulation thread */
+struct sim_state_t {
+    bool window_shown = false;
+    bool set_dir_1 = false;
+    bool set_dir_2 = false;
+    direction_t pacman_dir = direction_t::LEFT;
+    direction_t blinky_dir = direction_t::LEFT;
+    uint64_t tick_count = 0;
+};
+
+/** Initializes the given simulation input state, continuing the held directions of a replay's restart point */
+static void sim_init_state(sim_state_t& st) noexcept {
+    st.pacman_dir = pacman->direction();
+    if( input_replay_has_restart ) {
+        st.pacman_dir = input_replay_restart.pacman_dir;
+        st.set_dir_1 = input_replay_restart.set_dir_1;
+        st.blinky_dir = input_replay_restart.blinky_dir;
+        st.set_dir_2 = input_replay_restart.set_dir_2;
+    }
+}
+
+/**
+ * Records a pending level restart point with the given first tick after it,
+ * dropping the previous restart points no more required for the instant replay.
+ */
+static void sim_take_restart(const sim_state_t& st, const uint64_t tick) noexcept {
+    if( !level_restarted ) {
+        return;
+    }
+    level_restarted = false;
+    const uint64_t span = (uint64_t)instant_replay_sec * (uint64_t)get_frames_per_sec();
+    while( input_restarts.size() > 1 && input_restarts[1].tick + span <= tick ) {
+        input_restarts.pop_front();
+    }
+    input_restarts.push_back( input_restart_t { tick, input_history_seq, current_level, pacman->score(), pacman_t::fruit_rng_state(),
+                                                st.pacman_dir, st.set_dir_1, st.blinky_dir, st.set_dir_2,
+                                                global_maze->checksum(), level_spec_checksum() } );
+}
+
+static void sim_apply_input(sim_state_t& st, const game_input_t& in, const int start_level) noexcept {
+    switch( in.cmd ) {
+        case game_cmd_t::PACMAN_DIR:
+            st.pacman_dir = in.dir;
+            st.set_dir_1 = in.on;
+            break;
+        case game_cmd_t::BLINKY_DIR:
+            st.blinky_dir = in.dir;
+            st.set_dir_2 = in.on;
+            break;
+        case game_cmd_t::PAUSE:
+            if( game_mode_t::PAUSE == game_mode ) {
+                set_game_mode( game_mode_last, 13 );
+            } else {
+                set_game_mode( game_mode_t::PAUSE, 14 );
+            }
+            break;
+        case game_cmd_t::RESET:
+            current_level = start_level - 1;
+            pacman->reset_score();
+            set_game_mode(game_mode_t::NEXT_LEVEL, 15);
+            break;
+        case game_cmd_t::WINDOW_SHOWN:
+            st.window_shown = in.on;
+            return;
+        case game_cmd_t::DUMP_REPLAY:
+            dump_input_history(st.tick_count);
+            return;
+    }
+    const input_log_entry_t e { st.tick_count + 1, in };
+    if( nullptr != input_log_out ) {
+        print_input_log_entry(input_log_out, e);
+    }
+    input_history[input_history_seq++ % input_history_capacity] = e;
+    sim_take_restart(st, e.tick); // RESET
+}
+
+/** Consumes game_input, ignoring game commands while replaying. */
+static void sim_poll_input(sim_state_t& st, const int start_level) noexcept {
+    game_input_t in;
+    while( game_input.pop(in) ) {
+        if( input_replay_done || game_cmd_t::WINDOW_SHOWN == in.cmd || game_cmd_t::DUMP_REPLAY == in.cmd ) {
+            sim_apply_input(st, in, start_level);
+        }
+    }
+}
+
+/**
+ * Consumes game_input, or the replayed inputs of the upcoming tick while replaying,
+ * advances the simulation by one tick and publishes its frame_snapshot_t.
+ */
+static void sim_step(sim_state_t& st, const int start_level, ghost_ref blinky) noexcept {
+    const uint64_t tick = st.tick_count + 1;
+    sim_take_restart(st, tick); // initial level start
+    sim_poll_input(st, start_level);
+    if( !input_replay_done ) {
+        for(; input_replay_pos < input_replay.size() && input_replay[input_replay_pos].tick <= tick; ++input_replay_pos) {
+            sim_apply_input(st, input_replay[input_replay_pos].in, start_level);
+        }
+        if( input_replay_pos >= input_replay.size() && tick >= input_replay_end ) {
+            input_replay_done = true;
+        }
+    }
+    sim_tick(st.set_dir_1, st.pacman_dir, st.set_dir_2, st.blinky_dir, blinky);
+    sim_take_restart(st, tick + 1); // level completed
+    sim_capture(frame_snapshots.back(), ++st.tick_count);
+    frame_snapshots.publish();
+}
+
+/**
+ * Simulation thread main loop, consuming game_input and publishing frame_snapshots
+ * at get_frames_per_sec() ticks per second until sim_running is cleared.
+ */
+static void sim_main(const int start_level, ghost_ref blinky) noexcept {
+    sim_state_t st;
+    sim_init_state(st);
+    int64_t deadline_ns = get_monotonic_ns();
+
+    while( sim_running ) {
+        if( !st.window_shown ) {
+            sim_poll_input(st, start_level);
+            if( !st.window_shown ) {
+                SDL_Delay( 100 );
+                deadline_ns = get_monotonic_ns();
+                continue;
+            }
+        }
+        sim_step(st, start_level, blinky);
+
+        // absolute deadline pacing, resync if lagging more than one tick behind
+        const int64_t ns_per_tick = NanoPerOne / get_frames_per_sec();
+        deadline_ns += ns_per_tick;
+        const int64_t now_ns = get_monotonic_ns();
+        if( deadline_ns < now_ns - ns_per_tick ) {
+            deadline_ns = now_ns;
+        } else if( deadline_ns > now_ns ) {
+            struct timespec ts { deadline_ns / NanoPerOne, deadline_ns % NanoPerOne };
+            clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL );
+        }
+    }
+    close_input_log(st.tick_count);
+    if( input_dump_thread.joinable() ) {
+        input_dump_thread.join();
+    }
+}
+
+//
+// stress mode
+//
+
+/** Per frame timing statistics of the stress mode, see `-stress` */
+struct stress_stats_t {
+    uint64_t frames = 0;
+    int64_t sim_ns = 0, sim_max_ns = 0;
+    int64_t draw_ns = 0, draw_max_ns = 0;
+
+    void add(const int64_t sim_td_ns, const int64_t draw_td_ns) noexcept {
+        ++frames;
+        sim_ns += sim_td_ns;
+        sim_max_ns = std::max(sim_max_ns, sim_td_ns);
+        draw_ns += draw_td_ns;
+        draw_max_ns = std::max(draw_max_ns, draw_td_ns);
+    }
+
+    std::string toString() const noexcept {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        const double n = std::max<double>(1, frames);
+        std::string res(192, '\0');
+        const int written = std::snprintf(&res[0], res.size(), "stress[frames %" PRIu64 ", tick avg %.3f max %.3f ms, draw avg %.3f max %.3f ms, max rss %ld KiB]",
+                frames, sim_ns / n / NanoPerMilli, (double)sim_max_ns / NanoPerMilli,
+                draw_ns / n / NanoPerMilli, (double)draw_max_ns / NanoPerMilli, usage.ru_maxrss);
+        res.resize(written);
+        return res;
+    }
+};
+
+//
+// render thread
+//
+
+/**
+ * Draws the walls and gate of the original maze as filled boxes,
+ * merging horizontal runs of set bits within each bitboard row word.
+ *
+ * Used for mazes without texture, e.g. generated via `bin/maze_generate`.
+ */
+static void draw_maze_walls(SDL_Renderer* rend, const int x_pixel_offset) noexcept {
+    const int h = global_maze->height();
+    const int wpr = global_maze->words_per_row();
+    uint8_t r, g, b, a;
+    SDL_GetRenderDrawColor(rend, &r, &g, &b, &a);
+    for(const layer_t l : { layer_t::WALL, layer_t::GATE }) {
+        if( layer_t::WALL == l ) {
+            SDL_SetRenderDrawColor(rend, 33, 33, 222, 255);
+        } else {
+            SDL_SetRenderDrawColor(rend, 255, 184, 222, 255);
+        }
+        for(int y=0; y<h; ++y) {
+            for(int wi=0; wi<wpr; ++wi) {
+                uint32_t bits = global_maze->original_row_word(l, y, wi);
+                while( 0 != bits ) {
+                    const int b0 = __builtin_ctz(bits);
+                    const uint32_t gaps = ~( bits >> b0 );
+                    const int len = 0 != gaps ? __builtin_ctz(gaps) : 32 - b0;
+                    draw_box(rend, true, x_pixel_offset, 0, wi*32 + b0, y, len, 1);
+                    bits = b0 + len < 32 ? bits & ( ~0U << ( b0 + len ) ) : 0;
+                }
+            }
+        }
+    }
+    SDL_SetRenderDrawColor(rend, r, g, b, a);
+}
+
+/**
+ * Renders the given frame_snapshot_t, not including SDL_RenderPresent().
+ *
+ * @param alpha fraction [0..1] of the tick period elapsed since the snapshot's tick,
+ *        used to interpolate actor positions between the last two ticks, see actor_pos_t.
+ */
+static void draw_frame(SDL_Renderer* rend, const frame_snapshot_t& f, const float alpha,
+                       texture_t& maze_tex, const tex_region_t& pacman_left2_tex, const bool show_targets) noexcept
+{
+    SDL_RenderClear(rend);
+
+    const viewport_t& vp = win_viewport();
+    const int win_pixel_offset = vp.offset_x();
+
+    if( show_debug_gfx() ) {
+        uint8_t r, g, b, a;
+        SDL_GetRenderDrawColor(rend, &r, &g, &b, &a);
+        {
+            // Red Zones + Tunnel
+            const box_t& red_zone1 = global_maze->red_zone1_box();
+            const box_t& red_zone2 = global_maze->red_zone2_box();
+            const box_t& tunnel1 = global_maze->tunnel1_box();
+            const box_t& tunnel2 = global_maze->tunnel2_box();
+
+            SDL_SetRenderDrawColor(rend, 255, 96, 96, 100);
+            draw_box(rend, true, win_pixel_offset, 0, red_zone1.x(), red_zone1.y(), red_zone1.width(), red_zone1.height());
+            draw_box(rend, true, win_pixel_offset, 0, red_zone2.x(), red_zone2.y(), red_zone2.width(), red_zone2.height());
+
+            SDL_SetRenderDrawColor(rend, 96, 96, 255, 100);
+            draw_box(rend, true, win_pixel_offset, 0, tunnel1.x(), tunnel1.y(), tunnel1.width(), tunnel1.height());
+            draw_box(rend, true, win_pixel_offset, 0, tunnel2.x(), tunnel2.y(), tunnel2.width(), tunnel2.height());
+        }
+        {
+            // Grey Grid
+            SDL_SetRenderDrawColor(rend, 150, 150, 150, 255);
+            for(int y = global_maze->height()-1; y>=0; --y) {
+                draw_line(rend, 1, win_pixel_offset, 0, 0, y, global_maze->width(), y);
+            }
+            for(int x = global_maze->width()-1; x>=0; --x) {
+                draw_line(rend, 1, win_pixel_offset, 0, x, 0, x, global_maze->height());
+            }
+            flush_lines(rend);
+        }
+        {
+            // Filled check-boxes at 0/0 and each scatter target tile
+            acoord_t blinky_top_right = global_maze->top_right_scatter();
+            acoord_t pinky_top_left = global_maze->top_left_scatter();
+            acoord_t inky_bottom_right = global_maze->bottom_right_scatter();
+            acoord_t clyde_bottom_left = global_maze->bottom_left_scatter();
+
+            SDL_SetRenderDrawColor(rend, pacman_t::rgb_color[0], pacman_t::rgb_color[1], pacman_t::rgb_color[2], 255);
+            draw_box(rend, true, win_pixel_offset, 0, 0, 0, 1, 1);
+
+            SDL_SetRenderDrawColor(rend,
+                    ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::BLINKY ) ][0],
+                    ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::BLINKY ) ][1],
+                    ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::BLINKY ) ][2], 255);
+            draw_box(rend, true, win_pixel_offset, 0, blinky_top_right.x_i(),  blinky_top_right.y_i(), 1, 1);
+
+            SDL_SetRenderDrawColor(rend,
+                    ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::PINKY ) ][0],
+                    ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::PINKY ) ][1],
+                    ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::PINKY ) ][2], 255);
+            draw_box(rend, true, win_pixel_offset, 0, pinky_top_left.x_i(),    pinky_top_left.y_i(),    1, 1);
+
+            SDL_SetRenderDrawColor(rend,
+                    ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::INKY ) ][0],
+                    ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::INKY ) ][1],
+                    ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::INKY ) ][2], 255);
+            draw_box(rend, true, win_pixel_offset, 0, inky_bottom_right.x_i(), inky_bottom_right.y_i(), 1, 1);
+
+            SDL_SetRenderDrawColor(rend,
+                    ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::CLYDE ) ][0],
+                    ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::CLYDE ) ][1],
+                    ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::CLYDE ) ][2], 255);
+            draw_box(rend, true, win_pixel_offset, 0, clyde_bottom_left.x_i(), clyde_bottom_left.y_i(), 1, 1);
+        }
+        SDL_SetRenderDrawColor(rend, r, g, b, a);
+    }
+
+    if( nullptr != maze_tex.sdl_texture() ) {
+        maze_tex.draw(rend, 0, 0);
+    } else {
+        draw_maze_walls(rend, win_pixel_offset);
+    }
+
+    for(const tile_pos_t& t : f.tiles) {
+        global_tex->draw_tile(t.tile, rend, t.x, t.y, f.pellet_power_tex);
+    }
+
+    pacman_t::draw(rend, f.pacman, alpha);
+
+    ghost_t::global_draw(rend, f.ghosts, alpha);
+
+    if( show_targets ) {
+        const int pixel_width_scaled = std::max( 1, round_to_int( vp.scale() / 2.0f ) );
+        uint8_t r, g, b, a;
+        SDL_GetRenderDrawColor(rend, &r, &g, &b, &a);
+        for(const ghost_t::snapshot_t& gs : f.ghosts) {
+            if( gs.has_target ) {
+                float x, y;
+                gs.pos.interpolate(alpha, x, y);
+                SDL_SetRenderDrawColor(rend,
+                        ghost_t::rgb_color[ ghost_t::number( gs.id ) ][0],
+                        ghost_t::rgb_color[ ghost_t::number( gs.id ) ][1],
+                        ghost_t::rgb_color[ ghost_t::number( gs.id ) ][2], 255);
+                draw_line(rend, pixel_width_scaled, win_pixel_offset, 0, x, y, gs.target_x, gs.target_y);
+            }
+        }
+        flush_lines(rend);
+        SDL_SetRenderDrawColor(rend, r, g, b, a);
+    }
+
+    // top line: title
+    draw_text_scaled(rend, font_ttf(), "HIGH SCORE", 255, 255, 255, true /* cache */, [&](const texture_t& tex, int &x, int&y) {
+        x = ( vp.pixel_width() - tex.width() ) / 2;
+        y = vp.y_to_pixel(0);
+    });
+
+    // 2nd line - center: score
+    draw_text_scaled(rend, font_ttf(), std::to_string( f.score ), 255, 255, 255, false /* cache */, [&](const texture_t& tex, int &x, int&y) {
+        x = ( vp.pixel_width() - tex.width() ) / 2;
+        y = vp.y_to_pixel(1);
+    });
+
+    if( show_debug_gfx() ) {
+        // 2nd line - right: tiles
+        draw_text_scaled(rend, font_ttf(), std::to_string(f.pellets_left)+" / "+std::to_string(f.pellets_max),
+                         255, 255, 255, false /* cache */, [&](const texture_t& tex, int &x, int&y) {
+            x = vp.pixel_width() - tex.width();
+            y = vp.y_to_pixel(1);
+        });
+    }
+
+    // optional text
+    if( f.show_ready ) {
+        const box_t& msg_box = global_maze->message_box();
+        draw_text_scaled(rend, font_ttf(), "READY!",
+                         pacman_t::rgb_color[0], pacman_t::rgb_color[1], pacman_t::rgb_color[2],
+                         true /* cache */, [&](const texture_t& tex, int &x, int&y) {
+            x = vp.x_to_pixel(msg_box.center_x()) - tex.width()  / 2;
+            y = vp.y_to_pixel(msg_box.y()) - tex.height() / 4;
+        });
+    }
+
+    // bottom line: level
+    {
+        const float y = global_maze->height() - 2.0f;
+        float x = global_maze->width() - 4.0f;
+
+        for(int i=1; i <= f.level; ++i, x-=2) {
+            const tile_t ft = game_level_spec(i).symbol;
+            const tex_region_t f_tex = global_tex->texture(ft);
+            if( f_tex.is_valid() ) {
+                const float dx = ( 16.0f - f_tex.width ) / 2.0f / 16.0f;
+                const float dy = ( 16.0f - f_tex.height + 1.0f ) / 16.0f; // FIXME: funny adjustment?
+                f_tex.draw(rend, x+dx, y+dy);
+                // log_printf("XX1 level %d: %s, %.2f / %.2f + %.2f / %.2f = %.2f / %.2f\n", i, to_string(ft).c_str(), x, y, dx, dy, x+dx, y+dy);
+            }
+        }
+    }
+    // bottom line: lives left
+    {
+        const float dx = ( 16.0f - pacman_left2_tex.width ) / 2.0f / 16.0f;
+        const float dy = ( 16.0f - pacman_left2_tex.height + 1.0f ) / 16.0f; // FIXME: funny adjustment?
+        const float y = global_maze->height() - 2.0f;
+        float x = 2.0f;
+        for(int i=0; i < 2; ++i, x+=2) {
+            pacman_left2_tex.draw(rend, x+dx, y+dy);
+            // log_printf("XX2 %d: %.2f / %.2f + %.2f / %.2f = %.2f / %.2f\n", i, x, y, dx, dy, x+dx, y+dy);
+        }
+    }
+}
+
 int main(int argc, char *argv[])
 {
     bool enable_vsync = true;
@@ -388,16 +1382,33 @@ int main(int argc, char *argv[])
     bool invincible = false;
     bool show_targets = false;
     bool use_audio = false;
+    std::string audio_cache_dir;
     int pixel_filter_quality = 0;
     int start_level = 1;
     bool human_blinky = false;
     std::string record_bmpseq_basename;
+    std::string record_y4m_fname;
+    std::string record_delta_fname;
+    record_policy_t record_policy = record_policy_t::BLOCK;
+    record_format_t record_format = record_format_t::BMP;
+    bool headless = false;
+    uint64_t max_frames = 0;
+    std::string record_input_fname;
+    std::string replay_input_fname;
+    std::string maze_fname = "media/playfield_pacman.txt";
+    bool stress = false;
+    std::string level_spec_fname;
+    bool use_hot_reload = false;
+    int ghost_count = ghost_t::personality_count;
     {
         for(int i=1; i<argc; ++i) {
             if( 0 == strcmp("-2p", argv[i]) ) {
                 human_blinky = true;
             } else if( 0 == strcmp("-audio", argv[i]) ) {
                 use_audio = true;
+            } else if( 0 == strcmp("-audio_cache", argv[i]) && i+1<argc) {
+                audio_cache_dir = argv[i+1];
+                ++i;
             } else if( 0 == strcmp("-pixqual", argv[i]) && i+1<argc) {
                 pixel_filter_quality = atoi(argv[i+1]);
                 ++i;
@@ -407,6 +1418,9 @@ int main(int argc, char *argv[])
                 forced_fps = atoi(argv[i+1]);
                 enable_vsync = false;
                 ++i;
+            } else if( 0 == strcmp("-tps", argv[i]) && i+1<argc) {
+                frames_per_sec = std::max(1, atoi(argv[i+1]));
+                ++i;
             } else if( 0 == strcmp("-speed", argv[i]) && i+1<argc) {
                 fields_per_sec_total = atof(argv[i+1]);
                 ++i;
@@ -448,22 +1462,108 @@ int main(int argc, char *argv[])
             } else if( 0 == strcmp("-record", argv[i]) && i+1<argc) {
                 record_bmpseq_basename = argv[i+1];
                 ++i;
+            } else if( 0 == strcmp("-record_y4m", argv[i]) && i+1<argc) {
+                record_y4m_fname = argv[i+1];
+                ++i;
+            } else if( 0 == strcmp("-record_delta", argv[i]) && i+1<argc) {
+                record_delta_fname = argv[i+1];
+                ++i;
+            } else if( 0 == strcmp("-record_policy", argv[i]) && i+1<argc) {
+                if( !to_record_policy(argv[i+1], record_policy) ) {
+                    log_printf("Invalid record policy '%s'\n", argv[i+1]);
+                    return -1;
+                }
+                ++i;
+            } else if( 0 == strcmp("-record_format", argv[i]) && i+1<argc) {
+                if( !to_record_format(argv[i+1], record_format) ) {
+                    log_printf("Invalid record format '%s'\n", argv[i+1]);
+                    return -1;
+                }
+                ++i;
+            } else if( 0 == strcmp("-headless", argv[i]) ) {
+                headless = true;
+                enable_vsync = false;
+            } else if( 0 == strcmp("-frames", argv[i]) && i+1<argc) {
+                max_frames = std::max(0, atoi(argv[i+1]));
+                ++i;
+            } else if( 0 == strcmp("-record_input", argv[i]) && i+1<argc) {
+                record_input_fname = argv[i+1];
+                ++i;
+            } else if( 0 == strcmp("-replay_input", argv[i]) && i+1<argc) {
+                replay_input_fname = argv[i+1];
+                ++i;
+            } else if( 0 == strcmp("-maze", argv[i]) && i+1<argc) {
+                maze_fname = argv[i+1];
+                ++i;
+            } else if( 0 == strcmp("-stress", argv[i]) ) {
+                stress = true;
+                enable_vsync = false;
+            } else if( 0 == strcmp("-level_spec", argv[i]) && i+1<argc) {
+                level_spec_fname = argv[i+1];
+                ++i;
+            } else if( 0 == strcmp("-hot_reload", argv[i]) ) {
+                use_hot_reload = true;
+            } else if( 0 == strcmp("-ghosts", argv[i]) && i+1<argc) {
+                ghost_count = std::max(0, std::min(ghost_t::max_ghost_count, atoi(argv[i+1])));
+                ++i;
             }
         }
     }
     const std::string exename(argv[0]);
 
-    global_maze = std::make_unique<maze_t>("media/playfield_pacman.txt");
+    // A replay runs with its recorded simulation options, overriding the given ones
+    input_log_options_t replay_options;
+    if( replay_input_fname.size() > 0 ) {
+        if( !load_input_replay(replay_input_fname, replay_options) ) {
+            return -1;
+        }
+        start_level = replay_options.level;
+        human_blinky = replay_options.two_players;
+        original_pacman_behavior = !replay_options.bugfix;
+        decision_one_field_ahead = !replay_options.decision_on_spot;
+        manhatten_distance_enabled = replay_options.dist_manhatten;
+        frames_per_sec = replay_options.tps;
+        fields_per_sec_total = replay_options.speed;
+        disable_all_ghosts = replay_options.no_ghosts;
+        invincible = replay_options.invincible;
+        ghost_count = replay_options.ghosts;
+    }
+
+    // Invoked as pacman_render: render the replayed input headless as fast as possible, one frame per tick
+    const bool offline_render = "pacman_render" == exename.substr( exename.find_last_of('/') + 1 );
+    if( offline_render ) {
+        if( replay_input_fname.size() == 0 ) {
+            log_printf("%s: Missing -replay_input <file>\n\n%s\n", exename.c_str(), get_usage(exename).c_str());
+            return -1;
+        }
+        headless = true;
+        enable_vsync = false;
+        forced_fps = get_frames_per_sec();
+        record_policy = record_policy_t::BLOCK;
+    }
+    input_history.resize(input_history_capacity);
+
+    if( level_spec_fname.size() > 0 ) {
+        std::vector<game_level_spec_t> spec;
+        if( !load_level_spec(level_spec_fname, spec) ) {
+            return -1;
+        }
+        set_level_spec( std::move(spec) );
+    }
+
+    const uint64_t maze_t0 = getCurrentMilliseconds();
+    global_maze = std::make_unique<maze_t>(maze_fname);
+    const uint64_t maze_load_ms = getCurrentMilliseconds() - maze_t0;
     current_level = start_level;
 
     if( !global_maze->is_ok() ) {
         log_printf("Maze: Error: %s\n", global_maze->toString().c_str());
         return -1;
     }
-    {
+    if( global_maze->width() <= 64 ) {
         log_printf("--- 8< ---\n");
         const int maze_width = global_maze->width();
-        global_maze->draw( [&maze_width](float x, float y, tile_t tile) {
+        global_maze->for_each_tile( [&maze_width](const int x, const int y, const tile_t tile) {
             fprintf(stderr, "%s", to_string(tile).c_str());
             if( x == maze_width-1 ) {
                 fprintf(stderr, "\n");
@@ -471,15 +1571,35 @@ int main(int argc, char *argv[])
             (void)y;
         });
         log_printf("--- >8 ---\n");
-        log_printf("Maze: %s\n", global_maze->toString().c_str());
+    }
+    log_printf("Maze: %s, loaded in %" PRIu64 " ms\n", global_maze->toString().c_str(), maze_load_ms);
+
+    input_log_options = input_log_options_t { start_level, human_blinky, !original_pacman_behavior, !decision_one_field_ahead,
+                                              manhatten_distance_enabled, frames_per_sec, fields_per_sec_total,
+                                              disable_all_ghosts, invincible, ghost_count,
+                                              global_maze->checksum(), level_spec_checksum() };
+    if( replay_input_fname.size() > 0 ) {
+        if( replay_options.maze_checksum != input_log_options.maze_checksum ) {
+            log_printf("input replay: Error: Recorded maze %08x differs from %s %08x\n",
+                    replay_options.maze_checksum, maze_fname.c_str(), input_log_options.maze_checksum);
+            return -1;
+        }
+        if( replay_options.level_spec_checksum != input_log_options.level_spec_checksum ) {
+            log_printf("input replay: Error: Recorded level spec %08x differs from %s %08x\n",
+                    replay_options.level_spec_checksum, level_spec_fname.size()==0 ? "builtin" : level_spec_fname.c_str(),
+                    input_log_options.level_spec_checksum);
+            return -1;
+        }
     }
     {
         log_printf("\n%s\n\n", get_usage(exename).c_str());
         log_printf("- 2p %d\n", human_blinky);
         log_printf("- use_audio %d\n", use_audio);
+        log_printf("- audio_cache %s\n", audio_cache_dir.size()==0 ? "disabled" : audio_cache_dir.c_str());
         log_printf("- pixqual %d\n", pixel_filter_quality);
         log_printf("- enable_vsync %d\n", enable_vsync);
         log_printf("- forced_fps %d\n", forced_fps);
+        log_printf("- ticks_per_sec %d\n", get_frames_per_sec());
         log_printf("- fields_per_sec %5.2f\n", fields_per_sec_total);
         log_printf("- win size %d x %d\n", win_width, win_height);
         log_printf("- show_fps %d\n", log_fps());
@@ -494,9 +1614,25 @@ int main(int argc, char *argv[])
         log_printf("- distance %s\n", use_manhatten_distance() ? "Manhatten" : "Euclidean");
         log_printf("- level %d\n", get_current_level());
         log_printf("- record %s\n", record_bmpseq_basename.size()==0 ? "disabled" : record_bmpseq_basename.c_str());
+        log_printf("- record_y4m %s\n", record_y4m_fname.size()==0 ? "disabled" : record_y4m_fname.c_str());
+        log_printf("- record_delta %s\n", record_delta_fname.size()==0 ? "disabled" : record_delta_fname.c_str());
+        log_printf("- record_policy %s\n", to_string(record_policy).c_str());
+        log_printf("- record_format %s\n", to_string(record_format).c_str());
+        log_printf("- headless %d\n", headless);
+        log_printf("- frames %" PRIu64 "\n", max_frames);
+        log_printf("- record_input %s\n", record_input_fname.size()==0 ? "disabled" : record_input_fname.c_str());
+        log_printf("- replay_input %s\n", replay_input_fname.size()==0 ? "disabled" : replay_input_fname.c_str());
+        log_printf("- maze %s\n", maze_fname.c_str());
+        log_printf("- offline_render %d\n", offline_render);
+        log_printf("- stress %d\n", stress);
+        log_printf("- level_spec %s\n", level_spec_fname.size()==0 ? "builtin" : level_spec_fname.c_str());
+        log_printf("- hot_reload %d\n", use_hot_reload);
+        log_printf("- ghosts %d\n", ghost_count);
     }
 
-    if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
+    // headless mode renders without any display, hence skips video subsystem initialization
+    const Uint32 sdl_init_flags = headless ? SDL_INIT_TIMER | SDL_INIT_AUDIO | SDL_INIT_EVENTS : SDL_INIT_EVERYTHING;
+    if (SDL_Init(sdl_init_flags) != 0) {
         log_printf("SDL: Error initializing: %s\n", SDL_GetError());
     }
 
@@ -511,14 +1647,18 @@ int main(int argc, char *argv[])
     if( use_audio ) {
         use_audio = audio_open();
     }
+    // Audio clips are decoded in the background while the window, renderer and textures are created, see audio_loader->take() below
+    std::unique_ptr<audio_loader_t> audio_loader;
     if( use_audio ) {
-        audio_samples.push_back( std::make_shared<audio_sample_t>("media/intro.mp3") );
-        audio_samples.push_back( std::make_shared<audio_sample_t>("media/munch.wav") );
-        audio_samples.push_back( std::make_shared<audio_sample_t>("media/eatfruit.mp3") );
-        audio_samples.push_back( std::make_shared<audio_sample_t>("media/eatghost.mp3", false /* single_play */) );
-        audio_samples.push_back( std::make_shared<audio_sample_t>("media/death.mp3") );
-        // audio_samples.push_back( std::make_shared<audio_sample_t>("media/extrapac.mp3") );
-        // audio_samples.push_back( std::make_shared<audio_sample_t>("media/intermission.mp3") );
+        audio_loader = std::make_unique<audio_loader_t>(std::vector<audio_loader_t::clip_t>{
+            { "media/intro.mp3", true },
+            { "media/munch.wav", true },
+            { "media/eatfruit.mp3", true },
+            { "media/eatghost.mp3", false /* single_play */ },
+            { "media/death.mp3", true },
+            // { "media/extrapac.mp3", true },
+            // { "media/intermission.mp3", true },
+        }, audio_cache_dir);
     } else {
         for(int i=0; i <= number( audio_clip_t::DEATH ); ++i) {
             audio_samples.push_back( std::make_shared<audio_sample_t>() );
@@ -530,19 +1670,36 @@ int main(int argc, char *argv[])
     }
     SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, std::to_string(pixel_filter_quality).c_str());
 
-    SDL_Window* win = SDL_CreateWindow("Pacman",
-                                       SDL_WINDOWPOS_UNDEFINED,
-                                       SDL_WINDOWPOS_UNDEFINED,
-                                       win_width,
-                                       win_height,
-                                       SDL_WINDOW_ALLOW_HIGHDPI | SDL_WINDOW_RESIZABLE);
- 
-    const Uint32 render_flags = enable_vsync ? SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC :
-                                               SDL_RENDERER_ACCELERATED;
+    SDL_Window* win = nullptr;
+    SDL_Surface* headless_surface = nullptr;
+    SDL_Renderer* rend = nullptr;
     Uint32 fullscreen_flags = 0;
     bool uses_vsync = false;
 
-    SDL_Renderer* rend = SDL_CreateRenderer(win, -1, render_flags);
+    if( headless ) {
+        // Software renderer compositing into an in-memory ARGB8888 surface using SDL's (SIMD) blitters
+        headless_surface = SDL_CreateRGBSurfaceWithFormat(0, win_width, win_height, 32, SDL_PIXELFORMAT_ARGB8888);
+        if( nullptr == headless_surface ) {
+            log_printf("SDL: Error creating headless surface %d x %d: %s\n", win_width, win_height, SDL_GetError());
+            return -1;
+        }
+        rend = SDL_CreateSoftwareRenderer(headless_surface);
+    } else {
+        win = SDL_CreateWindow("Pacman",
+                               SDL_WINDOWPOS_UNDEFINED,
+                               SDL_WINDOWPOS_UNDEFINED,
+                               win_width,
+                               win_height,
+                               SDL_WINDOW_ALLOW_HIGHDPI | SDL_WINDOW_RESIZABLE);
+
+        const Uint32 render_flags = enable_vsync ? SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC :
+                                                   SDL_RENDERER_ACCELERATED;
+        rend = SDL_CreateRenderer(win, -1, render_flags);
+    }
+    if( nullptr == rend ) {
+        log_printf("SDL: Error creating renderer: %s\n", SDL_GetError());
+        return -1;
+    }
     {
         SDL_RendererInfo info;
         SDL_GetRendererInfo(rend, &info);
@@ -554,12 +1711,16 @@ int main(int argc, char *argv[])
         log_printf("renderer: vsync %d -> %d\n", _uses_vsync, uses_vsync);
     }
  
-    std::unique_ptr<texture_t> pacman_maze_tex = std::make_unique<texture_t>(rend, "media/"+global_maze->get_texture_file());
+    // texture file `-` denotes a maze without texture, drawn via draw_maze_walls()
+    std::unique_ptr<texture_t> pacman_maze_tex = "-" == global_maze->get_texture_file() ? std::make_unique<texture_t>() :
+                                                 std::make_unique<texture_t>(rend, "media/"+global_maze->get_texture_file());
     {
         int width=0;
         int height=0;
         SDL_GetRendererOutputSize(rend, &width, &height);
-        {
+        if( headless ) {
+            render_frames_per_sec = 0 < forced_fps ? forced_fps : get_frames_per_sec();
+        } else {
             SDL_DisplayMode mode;
             {
                 const int num_displays = SDL_GetNumVideoDisplays();
@@ -574,19 +1735,28 @@ int main(int argc, char *argv[])
             SDL_GetCurrentDisplayMode(win_display_idx, &mode); // SDL_GetWindowDisplayMode(..) fails on some systems (wrong refresh_rate and logical size
             log_printf("WindowDisplayMode: %d x %d @ %d Hz @ display %d\n", mode.w, mode.h, mode.refresh_rate, win_display_idx);
             if( 0 < forced_fps ) {
-                frames_per_sec = forced_fps;
+                render_frames_per_sec = forced_fps;
             } else {
-                frames_per_sec = mode.refresh_rate;
+                render_frames_per_sec = 0 < mode.refresh_rate ? mode.refresh_rate : get_frames_per_sec();
             }
         }
         on_window_resized(rend, width, height);
 
-        SDL_SetWindowSize(win, global_maze->pixel_width()*win_pixel_scale(),
-                               global_maze->pixel_height()*win_pixel_scale());
+        if( nullptr != win ) {
+            SDL_SetWindowSize(win, global_maze->pixel_width()*win_pixel_scale(),
+                                   global_maze->pixel_height()*win_pixel_scale());
+        }
     }
 
     global_tex = std::make_shared<global_tex_t>(rend);
-    std::shared_ptr<texture_t> pacman_left2_tex = std::make_shared<texture_t>(global_tex->all_images()->sdl_texture(), 0 + 1*13, 28 + 0, 13, 13, false /* owner*/);
+    const tex_handle_t pacman_left2_tex = register_tex_region(global_tex->all_images()->sdl_texture(), 0 + 1*13, 28 + 0, 13, 13);
+
+    // tiles and maze background are pre-scaled once per window size
+    add_scaled_tex_atlas(global_tex->all_images()->sdl_texture());
+    if( nullptr != pacman_maze_tex->sdl_texture() ) {
+        add_scaled_tex_atlas(pacman_maze_tex->sdl_texture());
+    }
+    rescale_tex_atlases(rend, win_pixel_scale());
 
     pacman = std::make_shared<pacman_t>(rend, fields_per_sec_total);
     pacman->set_invincible(invincible);
@@ -594,17 +1764,29 @@ int main(int argc, char *argv[])
 
     ghost_ref blinky = nullptr;
     if( !disable_all_ghosts ) {
-        ghosts_.push_back( std::make_shared<ghost_t>(ghost_t::personality_t::BLINKY, rend, fields_per_sec_total) );
-        ghosts_.push_back( std::make_shared<ghost_t>(ghost_t::personality_t::PINKY, rend, fields_per_sec_total) );
-        ghosts_.push_back( std::make_shared<ghost_t>(ghost_t::personality_t::INKY, rend, fields_per_sec_total) );
-        ghosts_.push_back( std::make_shared<ghost_t>(ghost_t::personality_t::CLYDE, rend, fields_per_sec_total) );
+        // constructed in place and never relocated, see ghosts()
+        ghosts_.reset(ghost_count);
+        for(int i=0; i<ghost_count; ++i) {
+            ghosts_.emplace_back(i, rend, fields_per_sec_total);
+        }
         blinky = ghost( ghost_t::personality_t::BLINKY );
-        if( human_blinky ) {
+        if( human_blinky && nullptr != blinky ) {
             blinky->set_manual_control(true);
         }
     }
-    for(ghost_ref g : ghosts()) {
-        log_printf("%s\n", g->toString().c_str());
+    for(const ghost_t& g : ghosts()) {
+        log_printf("%s\n", g.toString().c_str());
+    }
+    if( nullptr != audio_loader ) {
+        audio_loader->take(audio_samples);
+        audio_loader = nullptr;
+        // SDL_mixer is only entered by the audio thread, the simulation posts its requests via audio_play() and audio_stop()
+        audio_queue = std::make_unique<audio_queue_t>(audio_samples);
+    }
+    level_start_sound = replay_input_fname.size() > 0 ? replay_options.intro_sound : audio_samples[ number( audio_clip_t::INTRO ) ]->is_valid();
+    input_log_options.intro_sound = level_start_sound;
+    if( record_input_fname.size() > 0 && !open_input_log(record_input_fname) ) {
+        return -1;
     }
 
     bool window_shown = false;
@@ -620,16 +1802,79 @@ int main(int argc, char *argv[])
     uint64_t t0 = getCurrentMilliseconds();
     uint64_t t1 = t0;
     uint64_t frame_count = 0;
+    // simulation tick rate as seen by the render thread, taken from the published frame_snapshot_t::tick
+    uint64_t tick_t0 = 0;
+    uint64_t tick_t1 = 0;
     uint64_t frame_count_total = 0;
     int snapshot_counter = 0;
 
-    current_level = start_level - 1;
-    pacman->reset_score();
+    // Snapshots and recorded frames are written by bounded pools of writer threads, QOI frames are encoded in parallel stripes
+    std::unique_ptr<stripe_pool_t> stripe_pool;
+    if( record_format_t::QOI == record_format ) {
+        stripe_pool = std::make_unique<stripe_pool_t>();
+    }
+    frame_recorder_t snapshot_recorder(make_image_writer(record_format, stripe_pool.get()), 2, 1, record_policy_t::BLOCK);
+    std::unique_ptr<frame_recorder_t> recorder;
+    if( record_y4m_fname.size() > 0 ) {
+        std::unique_ptr<y4m_writer_t> y4m = std::make_unique<y4m_writer_t>(record_y4m_fname, render_frames_per_sec);
+        if( y4m->is_open() ) {
+            recorder = std::make_unique<frame_recorder_t>(std::move(y4m), 8, 1, record_policy);
+        }
+    } else if( record_delta_fname.size() > 0 ) {
+        std::unique_ptr<delta_writer_t> delta = std::make_unique<delta_writer_t>(record_delta_fname, render_frames_per_sec);
+        if( delta->is_open() ) {
+            recorder = std::make_unique<frame_recorder_t>(std::move(delta), 8, 1, record_policy);
+        }
+    } else if( record_bmpseq_basename.size() > 0 ) {
+        const size_t workers = record_format_t::PNG == record_format ? std::max(2u, std::thread::hardware_concurrency()) : 2;
+        recorder = std::make_unique<frame_recorder_t>(make_image_writer(record_format, stripe_pool.get()), 8, workers, record_policy);
+    }
+    // Recorded frames are read back one frame deferred, except the headless surface which is read directly
+    render_capture_t render_capture;
+
+    if( input_replay_has_restart ) {
+        current_level = input_replay_restart.level - 1;
+        pacman->set_score(input_replay_restart.score);
+        pacman_t::set_fruit_rng_state(input_replay_restart.fruit_rng);
+    } else {
+        current_level = start_level - 1;
+        pacman->reset_score();
+    }
     set_game_mode(game_mode_t::NEXT_LEVEL, 1);
 
+    if( headless ) {
+        // no window events
+        window_shown = true;
+        post_input(game_cmd_t::WINDOW_SHOWN, direction_t::LEFT, true);
+    }
+
+    // Simulation runs on its own thread, this thread handles SDL events and renders the latest frame_snapshot_t
+    sim_running = true;
+    // Offline rendering and the stress mode step the simulation on this thread instead, one tick per rendered frame
+    sim_state_t offline_sim;
+    sim_init_state(offline_sim);
+    stress_stats_t stress_stats;
+    std::thread sim_thread;
+    if( use_hot_reload && !offline_render ) {
+        // replays are no longer deterministic once the maze or level spec changes, hence not for pacman_render
+        hot_reload = std::make_unique<hot_reload_t>(maze_fname, level_spec_fname);
+        if( !hot_reload->start() ) {
+            hot_reload = nullptr;
+        }
+    }
+    if( !offline_render && !stress ) {
+        hot_swap_threaded = true;
+        sim_thread = std::thread(sim_main, start_level, blinky);
+    }
+
     while (!close) {
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
+            const bool set_dir_1_old = set_dir_1;
+            const bool set_dir_2_old = set_dir_2;
+            const direction_t pacman_dir_old = pacman_dir;
+            const direction_t blinky_dir_old = blinky_dir;
+
             switch (event.type) {
                 case SDL_QUIT:
                     close = true;
@@ -667,10 +1912,12 @@ int main(int argc, char *argv[])
                         case SDL_WINDOWEVENT_SHOWN:
                             // log_printf("Window Shown\n");
                             window_shown = true;
+                            post_input(game_cmd_t::WINDOW_SHOWN, direction_t::LEFT, true);
                             break;
                         case SDL_WINDOWEVENT_HIDDEN:
                             // log_printf("Window Hidden\n");
                             window_shown = false;
+                            post_input(game_cmd_t::WINDOW_SHOWN, direction_t::LEFT, false);
                             break;
                         case SDL_WINDOWEVENT_RESIZED:
                             // log_printf("Window Resize: %d x %d\n", event.window.data1, event.window.data2);
@@ -683,6 +1930,14 @@ int main(int argc, char *argv[])
                     }
                     break;
 
+                case SDL_RENDER_TARGETS_RESET:
+                    [[fallthrough]];
+                case SDL_RENDER_DEVICE_RESET:
+                    // pre-scaled texture atlas and capture target content is lost
+                    rescale_tex_atlases(rend, win_pixel_scale());
+                    render_capture.reset();
+                    break;
+
                 case SDL_KEYDOWN:
                     // keyboard API for key pressed
                     switch (event.key.keysym.scancode) {
@@ -692,16 +1947,10 @@ int main(int argc, char *argv[])
                             close = true;
                             break;
                         case SDL_SCANCODE_P:
-                            if( game_mode_t::PAUSE == game_mode ) {
-                                set_game_mode( game_mode_last, 13 );
-                            } else {
-                                set_game_mode( game_mode_t::PAUSE, 14 );
-                            }
+                            post_input(game_cmd_t::PAUSE, direction_t::LEFT, true);
                             break;
                         case SDL_SCANCODE_R:
-                            current_level = start_level - 1;
-                            pacman->reset_score();
-                            set_game_mode(game_mode_t::NEXT_LEVEL, 15);
+                            post_input(game_cmd_t::RESET, direction_t::LEFT, true);
                             break;
                         case SDL_SCANCODE_W:
                             if( human_blinky ) {
@@ -748,14 +1997,23 @@ int main(int argc, char *argv[])
                             set_dir_1 = true;
                             break;
                         case SDL_SCANCODE_F:
-                            fullscreen_flags = 0 == fullscreen_flags ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0;
-                            SDL_SetWindowFullscreen(win, fullscreen_flags);
+                            if( nullptr != win ) {
+                                fullscreen_flags = 0 == fullscreen_flags ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0;
+                                SDL_SetWindowFullscreen(win, fullscreen_flags);
+                            }
+                            break;
+                        case SDL_SCANCODE_F11:
+                            post_input(game_cmd_t::DUMP_REPLAY, direction_t::LEFT, true);
                             break;
                         case SDL_SCANCODE_F12: {
                             std::string snap_fname(128, '\0');
-                            const int written = std::snprintf(&snap_fname[0], snap_fname.size(), "puckman-snap-%4.4d.bmp", snapshot_counter);
+                            const int written = std::snprintf(&snap_fname[0], snap_fname.size(), "puckman-snap-%4.4d.%s", snapshot_counter, to_string(record_format).c_str());
                             snap_fname.resize(written);
-                            save_snapshot(rend, win_pixel_width(), win_pixel_height(), snap_fname);
+                            if( nullptr != headless_surface ) {
+                                snapshot_recorder.record(headless_surface, snap_fname);
+                            } else {
+                                snapshot_recorder.record(rend, win_pixel_width(), win_pixel_height(), snap_fname);
+                            }
                             ++snapshot_counter;
                             break;
                         }
@@ -773,224 +2031,83 @@ int main(int argc, char *argv[])
                                 event.key.keysym.scancode, to_string(pacman_dir).c_str(), pacman_scancode, blinky_scancode, set_dir_1, set_dir_2);
                     }
             }
+            if( set_dir_1 != set_dir_1_old || pacman_dir != pacman_dir_old ) {
+                post_input(game_cmd_t::PACMAN_DIR, pacman_dir, set_dir_1);
+            }
+            if( set_dir_2 != set_dir_2_old || blinky_dir != blinky_dir_old ) {
+                post_input(game_cmd_t::BLINKY_DIR, blinky_dir, set_dir_2);
+            }
         }
 
+        hot_swap_service();
+
         if( !window_shown ) {
             SDL_Delay( 100 );
             continue;
         }
-        bool game_active;
-
-        if( 0 < game_mode_ms_left ) {
-            game_mode_ms_left = std::max( 0, game_mode_ms_left - get_ms_per_frame() );
-        }
-
-        switch( game_mode ) {
-            case game_mode_t::START:
-                if( 0 == game_mode_ms_left ) {
-                    set_game_mode( game_mode_t::GAME, 20 );
-                    game_active = true;
-                } else {
-                    game_active = false;
-                }
-                break;
-            case game_mode_t::PAUSE:
-                game_active = false;
-                break;
-            case game_mode_t::GAME:
-                if( 0 == global_maze->count( tile_t::PELLET ) && 0 == global_maze->count( tile_t::PELLET_POWER ) ) {
-                    set_game_mode(game_mode_t::NEXT_LEVEL, 21);
-                }
-            [[fallthrough]];
-            default:
-                game_active = true;
-                break;
-        }
-
-        if( game_active ) {
-            if( set_dir_1 ) {
-                pacman->set_dir(pacman_dir);
-            }
-            if( set_dir_2 && nullptr != blinky ) {
-                blinky->set_dir(blinky_dir);
-            }
-            global_tex->tick();
-            ghost_t::global_tick();
-            if( !pacman->tick() ) {
-                // pacman caught and died .. post dead animation
-                set_game_mode( game_mode_t::START, 22 );
+        if( offline_render ) {
+            if( input_replay_done ) {
+                close = true;
+                continue;
             }
+            // fast forward to the replay's start tick without rendering
+            do {
+                sim_step(offline_sim, start_level, blinky);
+            } while( !input_replay_done && offline_sim.tick_count < input_replay_from );
         }
-        SDL_RenderClear(rend);
-
-        const int win_pixel_offset = ( win_pixel_width() - global_maze->pixel_width()*win_pixel_scale() ) / 2;
-
-        if( show_debug_gfx() ) {
-            uint8_t r, g, b, a;
-            SDL_GetRenderDrawColor(rend, &r, &g, &b, &a);
-            {
-                // Red Zones + Tunnel
-                const box_t& red_zone1 = global_maze->red_zone1_box();
-                const box_t& red_zone2 = global_maze->red_zone2_box();
-                const box_t& tunnel1 = global_maze->tunnel1_box();
-                const box_t& tunnel2 = global_maze->tunnel2_box();
-
-                SDL_SetRenderDrawColor(rend, 255, 96, 96, 100);
-                draw_box(rend, true, win_pixel_offset, 0, red_zone1.x(), red_zone1.y(), red_zone1.width(), red_zone1.height());
-                draw_box(rend, true, win_pixel_offset, 0, red_zone2.x(), red_zone2.y(), red_zone2.width(), red_zone2.height());
-
-                SDL_SetRenderDrawColor(rend, 96, 96, 255, 100);
-                draw_box(rend, true, win_pixel_offset, 0, tunnel1.x(), tunnel1.y(), tunnel1.width(), tunnel1.height());
-                draw_box(rend, true, win_pixel_offset, 0, tunnel2.x(), tunnel2.y(), tunnel2.width(), tunnel2.height());
-            }
-            {
-                // Grey Grid
-                SDL_SetRenderDrawColor(rend, 150, 150, 150, 255);
-                for(int y = global_maze->height()-1; y>=0; --y) {
-                    draw_line(rend, 1, win_pixel_offset, 0, 0, y, global_maze->width(), y);
-                }
-                for(int x = global_maze->width()-1; x>=0; --x) {
-                    draw_line(rend, 1, win_pixel_offset, 0, x, 0, x, global_maze->height());
-                }
-            }
-            {
-                // Filled check-boxes at 0/0 and each scatter target tile
-                acoord_t blinky_top_right = global_maze->top_right_scatter();
-                acoord_t pinky_top_left = global_maze->top_left_scatter();
-                acoord_t inky_bottom_right = global_maze->bottom_right_scatter();
-                acoord_t clyde_bottom_left = global_maze->bottom_left_scatter();
-
-                SDL_SetRenderDrawColor(rend, pacman_t::rgb_color[0], pacman_t::rgb_color[1], pacman_t::rgb_color[2], 255);
-                draw_box(rend, true, win_pixel_offset, 0, 0, 0, 1, 1);
-
-                SDL_SetRenderDrawColor(rend,
-                        ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::BLINKY ) ][0],
-                        ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::BLINKY ) ][1],
-                        ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::BLINKY ) ][2], 255);
-                draw_box(rend, true, win_pixel_offset, 0, blinky_top_right.x_i(),  blinky_top_right.y_i(), 1, 1);
-
-                SDL_SetRenderDrawColor(rend,
-                        ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::PINKY ) ][0],
-                        ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::PINKY ) ][1],
-                        ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::PINKY ) ][2], 255);
-                draw_box(rend, true, win_pixel_offset, 0, pinky_top_left.x_i(),    pinky_top_left.y_i(),    1, 1);
-
-                SDL_SetRenderDrawColor(rend,
-                        ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::INKY ) ][0],
-                        ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::INKY ) ][1],
-                        ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::INKY ) ][2], 255);
-                draw_box(rend, true, win_pixel_offset, 0, inky_bottom_right.x_i(), inky_bottom_right.y_i(), 1, 1);
-
-                SDL_SetRenderDrawColor(rend,
-                        ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::CLYDE ) ][0],
-                        ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::CLYDE ) ][1],
-                        ghost_t::rgb_color[ ghost_t::number( ghost_t::personality_t::CLYDE ) ][2], 255);
-                draw_box(rend, true, win_pixel_offset, 0, clyde_bottom_left.x_i(), clyde_bottom_left.y_i(), 1, 1);
-            }
-            SDL_SetRenderDrawColor(rend, r, g, b, a);
+        int64_t stress_t0 = 0, stress_t1 = 0;
+        if( stress ) {
+            stress_t0 = get_monotonic_ns();
+            sim_step(offline_sim, start_level, blinky);
+            stress_t1 = get_monotonic_ns();
         }
-
-        pacman_maze_tex->draw(rend, 0, 0);
-
-        global_maze->draw( [&rend](float x, float y, tile_t tile) {
-            global_tex->draw_tile(tile, rend, x, y);
-        });
-
-        pacman->draw(rend);
-
-        ghost_t::global_draw(rend);
-
-        if( show_targets ) {
-            const int pixel_width_scaled = std::max( 1, round_to_int( win_pixel_scale() / 2.0f ) );
-            uint8_t r, g, b, a;
-            SDL_GetRenderDrawColor(rend, &r, &g, &b, &a);
-            for(ghost_ref ghost : ghosts()) {
-                if( ghost->is_scattering_or_chasing() ) {
-                    const acoord_t& p1 = ghost->position();
-                    const acoord_t& p2 = ghost->target();
-                    SDL_SetRenderDrawColor(rend,
-                            ghost_t::rgb_color[ ghost_t::number( ghost->id() ) ][0],
-                            ghost_t::rgb_color[ ghost_t::number( ghost->id() ) ][1],
-                            ghost_t::rgb_color[ ghost_t::number( ghost->id() ) ][2], 255);
-                    draw_line(rend, pixel_width_scaled, win_pixel_offset, 0, p1.x_f(), p1.y_f(), p2.x_f(), p2.y_f());
-                }
-            }
-            SDL_SetRenderDrawColor(rend, r, g, b, a);
+        frame_snapshots.update();
+        const frame_snapshot_t& frame = frame_snapshots.front();
+        if( 0 == frame.tick ) {
+            // no frame published yet
+            SDL_Delay( 1 );
+            continue;
         }
-
-        // top line: title
-        draw_text_scaled(rend, font_ttf(), "HIGH SCORE", 255, 255, 255, true /* cache */, [&](const texture_t& tex, int &x, int&y) {
-            x = ( global_maze->pixel_width()*win_pixel_scale() - tex.width() ) / 2;
-            y = global_maze->x_to_pixel(0, win_pixel_scale());
-        });
-
-        // 2nd line - center: score
-        draw_text_scaled(rend, font_ttf(), std::to_string( pacman->score() ), 255, 255, 255, false /* cache */, [&](const texture_t& tex, int &x, int&y) {
-            x = ( global_maze->pixel_width()*win_pixel_scale() - tex.width() ) / 2;
-            y = global_maze->x_to_pixel(1, win_pixel_scale());
-        });
-
-        if( show_debug_gfx() ) {
-            // 2nd line - right: tiles
-            draw_text_scaled(rend, font_ttf(), std::to_string(global_maze->count(tile_t::PELLET))+" / "+std::to_string(global_maze->max(tile_t::PELLET)),
-                             255, 255, 255, false /* cache */, [&](const texture_t& tex, int &x, int&y) {
-                x = global_maze->pixel_width()*win_pixel_scale() - tex.width();
-                y = global_maze->x_to_pixel(1, win_pixel_scale());
-            });
+        tick_t1 = frame.tick;
+        if( 0 == tick_t0 ) {
+            tick_t0 = tick_t1;
         }
-
-        // optional text
-        if( game_mode_t::START == game_mode ) {
-            const box_t& msg_box = global_maze->message_box();
-            draw_text_scaled(rend, font_ttf(), "READY!",
-                             pacman_t::rgb_color[0], pacman_t::rgb_color[1], pacman_t::rgb_color[2],
-                             true /* cache */, [&](const texture_t& tex, int &x, int&y) {
-                x = global_maze->x_to_pixel(msg_box.center_x(), win_pixel_scale()) - tex.width()  / 2;
-                y = global_maze->x_to_pixel(msg_box.y(), win_pixel_scale()) - tex.height() / 4;
-            });
+        std::string record_fname;
+        if( nullptr != recorder && record_bmpseq_basename.size() > 0 ) {
+            record_fname.resize(128, '\0');
+            const int written = std::snprintf(&record_fname[0], record_fname.size(), "%s-%7.7" PRIu64 ".%s", record_bmpseq_basename.c_str(), frame_count_total, to_string(record_format).c_str());
+            record_fname.resize(written);
         }
-
-        // bottom line: level
+        const bool captured = nullptr != recorder && nullptr == headless_surface &&
+                              render_capture.begin(rend, win_pixel_width(), win_pixel_height(), *recorder);
         {
-            const float y = 34.0f;
-            float x = 24.0f;
-
-            for(int i=1; i <= get_current_level(); ++i, x-=2) {
-                const tile_t f = game_level_spec(i).symbol;
-                std::shared_ptr<texture_t> f_tex = global_tex->texture(f);
-                if( nullptr != f_tex ) {
-                    const float dx = ( 16.0f - f_tex->width() ) / 2.0f / 16.0f;
-                    const float dy = ( 16.0f - f_tex->height() + 1.0f ) / 16.0f; // FIXME: funny adjustment?
-                    f_tex->draw(rend, x+dx, y+dy);
-                    // log_printf("XX1 level %d: %s, %.2f / %.2f + %.2f / %.2f = %.2f / %.2f\n", i, to_string(f).c_str(), x, y, dx, dy, x+dx, y+dy);
-                }
-            }
+            const float alpha = offline_render || stress ? 1.0f : (float)( get_monotonic_ns() - frame.tick_ns ) / (float)( NanoPerOne / get_frames_per_sec() );
+            draw_frame(rend, frame, std::max(0.0f, std::min(1.0f, alpha)), *pacman_maze_tex, get_tex_region(pacman_left2_tex), show_targets);
         }
-        // bottom line: lives left
-        if( nullptr != pacman_left2_tex ) {
-            const float dx = ( 16.0f - pacman_left2_tex->width() ) / 2.0f / 16.0f;
-            const float dy = ( 16.0f - pacman_left2_tex->height() + 1.0f ) / 16.0f; // FIXME: funny adjustment?
-            const float y = 34.0f;
-            float x = 2.0f;
-            for(int i=0; i < 2; ++i, x+=2) {
-                pacman_left2_tex->draw(rend, x+dx, y+dy);
-                // log_printf("XX2 %d: %.2f / %.2f + %.2f / %.2f = %.2f / %.2f\n", i, x, y, dx, dy, x+dx, y+dy);
-            }
+        if( captured ) {
+            render_capture.end(rend, record_fname);
         }
  
         // swap double buffer incl. v-sync
         SDL_RenderPresent(rend);
-        if( record_bmpseq_basename.size() > 0 ) {
-            std::string snap_fname(128, '\0');
-            const int written = std::snprintf(&snap_fname[0], snap_fname.size(), "%s-%7.7" PRIu64 ".bmp", record_bmpseq_basename.c_str(), frame_count_total);
-            snap_fname.resize(written);
-            save_snapshot(rend, win_pixel_width(), win_pixel_height(), snap_fname);
+        if( stress ) {
+            stress_stats.add(stress_t1 - stress_t0, get_monotonic_ns() - stress_t1);
+        }
+        if( nullptr != recorder && !captured ) {
+            if( nullptr != headless_surface ) {
+                recorder->record(headless_surface, record_fname);
+            } else {
+                recorder->record(rend, win_pixel_width(), win_pixel_height(), record_fname);
+            }
         }
         ++frame_count;
         ++frame_count_total;
-        if( !uses_vsync ) {
+        if( 0 < max_frames && frame_count_total >= max_frames ) {
+            close = true;
+        }
+        if( !uses_vsync && !offline_render && !stress ) {
             const int64_t fudge_ns = NanoPerMilli / 4;
-            const uint64_t ms_per_frame = (uint64_t)std::round(1000.0 / (float)get_frames_per_sec());
+            const uint64_t ms_per_frame = (uint64_t)std::round(1000.0 / (float)render_frames_per_sec);
             const uint64_t ms_last_frame = getCurrentMilliseconds() - t1;
             int64_t td_ns = int64_t( ms_per_frame - ms_last_frame ) * NanoPerMilli;
             if( td_ns > fudge_ns )
@@ -1009,29 +2126,69 @@ int main(int argc, char *argv[])
         t1 = getCurrentMilliseconds();
         if( log_fps() && fps_range_ms <= t1 - t0 ) {
             const float fps = get_fps(t0, t1, frame_count);
+            const float tps = get_fps(t0, t1, tick_t1 - tick_t0);
             std::string fps_str(64, '\0');
-            const int written = std::snprintf(&fps_str[0], fps_str.size(), "fps %6.2f", fps);
+            const int written = std::snprintf(&fps_str[0], fps_str.size(), "fps %6.2f, tps %6.2f", fps, tps);
             fps_str.resize(written);
             // log_printf("%s, td %" PRIu64 "ms, frames %" PRIu64 "\n", fps_str.c_str(), t1-t0, frame_count);
             log_printf("%s\n", fps_str.c_str());
+            if( nullptr != recorder ) {
+                log_printf("%s\n", recorder->toString().c_str());
+            }
+            if( stress ) {
+                log_printf("%s\n", stress_stats.toString().c_str());
+            }
             t0 = t1;
             frame_count = 0;
+            tick_t0 = tick_t1;
         }
     } // loop
 
+    hot_swap_threaded = false;
+    sim_running = false;
+    if( stress ) {
+        log_printf("Maze %d x %d, %s, loaded in %" PRIu64 " ms: %s\n", global_maze->width(), global_maze->height(),
+                   global_maze->nav_graph().toString().c_str(), maze_load_ms, stress_stats.toString().c_str());
+    }
+    if( offline_render || stress ) {
+        close_input_log(offline_sim.tick_count);
+        if( input_dump_thread.joinable() ) {
+            input_dump_thread.join();
+        }
+    } else {
+        sim_thread.join();
+    }
+    if( nullptr != hot_reload ) {
+        hot_reload->stop();
+        hot_reload = nullptr;
+    }
+    if( nullptr != recorder ) {
+        render_capture.flush(rend, *recorder);
+        recorder->stop();
+    }
+    render_capture.destroy();
+    snapshot_recorder.stop();
+
     if( use_audio ) {
+        audio_queue = nullptr;
         audio_samples.clear();
         audio_close();
     }
     ghosts_.clear();
     pacman->destroy();
-    pacman_left2_tex->destroy();
+    clear_scaled_tex_atlases();
     global_tex->destroy();
+    clear_tex_registry();
     pacman_maze_tex->destroy();
 
     SDL_DestroyRenderer(rend);
  
-    SDL_DestroyWindow(win);
+    if( nullptr != win ) {
+        SDL_DestroyWindow(win);
+    }
+    if( nullptr != headless_surface ) {
+        SDL_FreeSurface(headless_surface);
+    }
 
     TTF_CloseFont(font_ttf());
 
@@ -46,6 +46,41 @@ int ghost_t::global_wave_count = 0;
 bool ghost_t::global_pellet_counter_active = false;
 int ghost_t::global_pellet_counter = 0;
 int ghost_t::global_pellet_time_left = 0;
+occupancy_grid_t ghost_t::occupancy_;
+
+static const ghost_t::traits_t personality_traits[ghost_t::personality_count] = {
+    // look                           CHASE target rule                      SCATTER corner                   limit idx  limit extra  home dx  outside  elroy
+    { ghost_t::personality_t::BLINKY, ghost_t::target_rule_t::PACMAN,        ghost_t::corner_t::TOP_RIGHT,    0,         0,            0.0f,   true,    true  },
+    { ghost_t::personality_t::PINKY,  ghost_t::target_rule_t::AHEAD,         ghost_t::corner_t::TOP_LEFT,     1,         0,            0.0f,   false,   false },
+    { ghost_t::personality_t::INKY,   ghost_t::target_rule_t::MIRROR_BLINKY, ghost_t::corner_t::BOTTOM_RIGHT, 2,         0,           -2.0f,   false,   false },
+    { ghost_t::personality_t::CLYDE,  ghost_t::target_rule_t::SHY,           ghost_t::corner_t::BOTTOM_LEFT,  3,         0,            2.0f,   false,   false }
+};
+
+ghost_t::traits_t ghost_t::traits_of(const int index) noexcept {
+    const int i = std::max(0, index);
+    traits_t t = personality_traits[ i % personality_count ];
+    if( personality_count <= i ) {
+        // additional ghosts start inside the house and are released after the originals
+        t.pellet_limit_extra = ( i / personality_count ) * extra_pellet_limit;
+        t.start_outside = false;
+        t.elroy = false;
+        if( 0.0f == t.home_dx ) {
+            t.home_dx = ghost_t::personality_t::BLINKY == t.look ? -1.0f : 1.0f;
+        }
+    }
+    return t;
+}
+
+/** Returns the maze scatter position of the given corner. */
+static const acoord_t& corner_pos(const ghost_t::corner_t c) noexcept {
+    switch( c ) {
+        case ghost_t::corner_t::TOP_LEFT: return global_maze->top_left_scatter();
+        case ghost_t::corner_t::TOP_RIGHT: return global_maze->top_right_scatter();
+        case ghost_t::corner_t::BOTTOM_RIGHT: return global_maze->bottom_right_scatter();
+        case ghost_t::corner_t::BOTTOM_LEFT: [[fallthrough]];
+        default: return global_maze->bottom_left_scatter();
+    }
+}
 
 int ghost_t::id_to_yoff(ghost_t::personality_t id) noexcept {
     switch( id ) {
@@ -81,12 +116,14 @@ animtex_t& ghost_t::get_tex() noexcept {
     }
 }
 
-ghost_t::ghost_t(const personality_t id__, SDL_Renderer* rend, const float fields_per_sec_total_) noexcept
+ghost_t::ghost_t(const int index__, SDL_Renderer* rend, const float fields_per_sec_total_) noexcept
 : fields_per_sec_total(fields_per_sec_total_),
   current_speed_pct(0.0f),
   keyframei_(get_frames_per_sec(), fields_per_sec_total*current_speed_pct, true /* nearest */),
   sync_next_frame_cntr( keyframei_.sync_frame_count(), true /* auto_reload */),
-  id_( id__ ),
+  id_( traits_of(index__).look ),
+  index_( index__ ),
+  traits_( traits_of(index__) ),
   live_counter_during_pacman_live( 0 ),
   mode_( mode_t::AWAY ),
   mode_last( mode_t::AWAY ),
@@ -103,16 +140,12 @@ ghost_t::ghost_t(const personality_t id__, SDL_Renderer* rend, const float field
   dir_next( current_dir ),
   pos_next(-1, -1)
 {
-    if( ghost_t::personality_t::BLINKY == id_ ) {
+    if( traits_.start_outside ) {
         // positioned outside of the box at start
         home_pos = acoord_t( global_maze->ghost_start_box().center_x()-0.0f, global_maze->ghost_start_box().y()-0.0f );
         // home_pos = acoord_t( global_maze->ghost_home_int_box().center_x(), global_maze->ghost_home_int_box().center_y() );
-    } else if( ghost_t::personality_t::PINKY == id_ ) {
-        home_pos = acoord_t( global_maze->ghost_home_int_box().center_x()-0.0f, global_maze->ghost_home_int_box().center_y()-0.0f );
-    } else if( ghost_t::personality_t::INKY == id_ ) {
-        home_pos = acoord_t( global_maze->ghost_home_int_box().center_x()-2.0f, global_maze->ghost_home_int_box().center_y()-0.0f );
     } else {
-        home_pos = acoord_t( global_maze->ghost_home_int_box().center_x()+2.0f, global_maze->ghost_home_int_box().center_y()-0.0f );
+        home_pos = acoord_t( global_maze->ghost_home_int_box().center_x()+traits_.home_dx, global_maze->ghost_home_int_box().center_y()-0.0f );
     }
     pos_ = home_pos;
     target_ = home_pos;
@@ -153,11 +186,11 @@ void ghost_t::set_next_target() noexcept {
             break;
 
         case mode_t::CHASE:
-            switch( id_ ) {
-                case ghost_t::personality_t::BLINKY:
+            switch( traits_.chase_rule ) {
+                case target_rule_t::PACMAN:
                     target_ = pacman->position();
                     break;
-                case ghost_t::personality_t::PINKY: {
+                case target_rule_t::AHEAD: {
                     acoord_t p = pacman->position();
                     if( use_original_pacman_behavior() && direction_t::UP == pacman->direction() ) {
                         // See http://donhodges.com/pacman_pinky_explanation.htm
@@ -170,7 +203,7 @@ void ghost_t::set_next_target() noexcept {
                     target_ = p;
                     break;
                 }
-                case ghost_t::personality_t::INKY: {
+                case target_rule_t::MIRROR_BLINKY: {
                     /**
                      * Selecting the position two tiles in front of Pac-Man in his current direction of travel.
                      * From there, imagine drawing a vector from Blinky's position to this tile,
@@ -178,7 +211,8 @@ void ghost_t::set_next_target() noexcept {
                      * The tile that this new, extended vector ends on will be Inky's actual target.
                      */
                     acoord_t p = pacman->position();
-                    acoord_t b = ghost( ghost_t::personality_t::BLINKY )->position();
+                    const ghost_ref blinky = ghost( ghost_t::personality_t::BLINKY );
+                    acoord_t b = nullptr != blinky ? blinky->position() : pos_;
                     p.incr_fwd(keyframei_, 2);
                     float p_[] = { p.x_f(), p.y_f() };
                     float b_[] = { b.x_f(), b.y_f() };
@@ -188,14 +222,14 @@ void ghost_t::set_next_target() noexcept {
                     target_ = p;
                     break;
                 }
-                case ghost_t::personality_t::CLYDE: {
+                case target_rule_t::SHY: {
                     acoord_t p = pacman->position();
                     const float d_p = pos_.sq_distance(p);
                     // farther than eight tiles away, his targeting is identical to Blinky
                     if( d_p > 8*8 ) {
                         target_ = pacman->position();
                     } else {
-                        target_ = global_maze->bottom_left_scatter();
+                        target_ = corner_pos( traits_.scatter_corner );
                         target_.set_centered(keyframei_);
                     }
                     break;
@@ -207,27 +241,12 @@ void ghost_t::set_next_target() noexcept {
             break;
 
         case mode_t::SCATTER:
-            switch( id_ ) {
-                case ghost_t::personality_t::BLINKY:
-                    target_ = global_maze->top_right_scatter();
-                    break;
-                case ghost_t::personality_t::PINKY:
-                    target_ = global_maze->top_left_scatter();
-                    break;
-                case ghost_t::personality_t::INKY:
-                    target_ = global_maze->bottom_right_scatter();
-                    break;
-                case ghost_t::personality_t::CLYDE:
-                    [[fallthrough]];
-                default:
-                    target_ = global_maze->bottom_left_scatter();
-                    break;
-            }
+            target_ = corner_pos( traits_.scatter_corner );
             target_.set_centered(keyframei_);
             break;
 
         case mode_t::PHANTOM:
-            if( ghost_t::personality_t::BLINKY == id_ ) {
+            if( traits_.start_outside ) {
                 target_ = acoord_t( global_maze->ghost_home_int_box().center_x(), global_maze->ghost_home_int_box().center_y() );
             } else {
                 target_ = home_pos;
@@ -493,6 +512,9 @@ void ghost_t::set_global_mode(const mode_t m, const int mode_ms) noexcept {
         case mode_t::AWAY:
             break;
         case mode_t::LEVEL_SETUP:
+            // as initialized, making each level start a replayable restart point
+            global_mode_last = mode_t::AWAY;
+            global_mode_last_ms_left = 0;
             global_pellet_counter_active = false;
             global_pellet_counter = 0;
             global_pellet_time_left = game_level_spec().ghost_max_home_time_ms;
@@ -507,26 +529,26 @@ void ghost_t::set_global_mode(const mode_t m, const int mode_ms) noexcept {
             break;
         case mode_t::CHASE:
             propagate = false;
-            for(ghost_ref g : ghosts()) {
-                if( g->is_scattering_or_chasing() ) {
-                    g->set_mode( global_mode, global_mode_ms_left );
+            for(ghost_t& g : ghosts()) {
+                if( g.is_scattering_or_chasing() ) {
+                    g.set_mode( global_mode, global_mode_ms_left );
                 }
             }
             ++global_wave_count;
             break;
         case mode_t::SCATTER:
             propagate = false;
-            for(ghost_ref g : ghosts()) {
-                if( g->is_scattering_or_chasing() ) {
-                    g->set_mode( global_mode, global_mode_ms_left );
+            for(ghost_t& g : ghosts()) {
+                if( g.is_scattering_or_chasing() ) {
+                    g.set_mode( global_mode, global_mode_ms_left );
                 }
             }
             break;
         case mode_t::SCARED:
             propagate = false;
-            for(ghost_ref g : ghosts()) {
-                if( !g->in_house() && mode_t::PHANTOM != g->mode() ) {
-                    g->set_mode( global_mode, global_mode_ms_left );
+            for(ghost_t& g : ghosts()) {
+                if( !g.in_house() && mode_t::PHANTOM != g.mode() ) {
+                    g.set_mode( global_mode, global_mode_ms_left );
                 }
             }
             break;
@@ -539,8 +561,8 @@ void ghost_t::set_global_mode(const mode_t m, const int mode_ms) noexcept {
             return;
     }
     if( propagate ) {
-        for(ghost_ref g : ghosts()) {
-            g->set_mode( global_mode, global_mode_ms_left );
+        for(ghost_t& g : ghosts()) {
+            g.set_mode( global_mode, global_mode_ms_left );
         }
     }
     if( log_modes() ) {
@@ -609,14 +631,42 @@ void ghost_t::global_tick() noexcept {
                 break;
         }
     }
-    for(ghost_ref g : ghosts()) {
-        g->tick();
+    for(ghost_t& g : ghosts()) {
+        g.tick();
     }
 }
 
-void ghost_t::global_draw(SDL_Renderer* rend) noexcept {
-    for(ghost_ref g : ghosts()) {
-        g->draw(rend);
+void ghost_t::global_snapshot(std::vector<snapshot_t>& dest) noexcept {
+    dest.clear();
+    for(ghost_t& g : ghosts()) {
+        dest.push_back( g.get_snapshot() );
+    }
+    // hide ghosts within pacman's freeze box, only visiting its tiles
+    const box_t& fb = pacman->freeze_box();
+    const inplace_array_t<ghost_t>& gs = ghosts();
+    occupancy_.for_each_in_box(fb.x(), fb.y(), fb.width(), fb.height(), [&](const int i) {
+        if( (size_t)i < dest.size() && gs[i].pos_.intersects_i( fb ) ) {
+            dest[i].visible = false;
+        }
+    });
+}
+
+void ghost_t::update_occupancy() noexcept {
+    const inplace_array_t<ghost_t>& gs = ghosts();
+    if( occupancy_.width() != global_maze->width() || occupancy_.height() != global_maze->height() ||
+        occupancy_.actor_count() != (int)gs.size() )
+    {
+        occupancy_.reset(global_maze->width(), global_maze->height(), (int)gs.size());
+        for(size_t i=0; i<gs.size(); ++i) {
+            occupancy_.update((int)i, gs[i].pos_.x_i(), gs[i].pos_.y_i());
+        }
+    }
+    occupancy_.update(index_, pos_.x_i(), pos_.y_i());
+}
+
+void ghost_t::global_draw(SDL_Renderer* rend, const std::vector<snapshot_t>& snapshots, const float alpha) noexcept {
+    for(const snapshot_t& s : snapshots) {
+        draw(rend, s, alpha);
     }
 }
 
@@ -637,7 +687,7 @@ bool ghost_t::set_mode_speed() noexcept {
         case mode_t::CHASE:
             [[fallthrough]];
         case mode_t::SCATTER: {
-            if( ghost_t::personality_t::BLINKY == id_ ) {
+            if( traits_.elroy ) {
                 const int pellets_left = global_maze->count(tile_t::PELLET);
                 if( pellets_left <= game_level_spec().elroy2_dots_left ) { // elroy2_dots < elroy1_dots
                     return set_speed(game_level_spec().elroy2_speed);
@@ -677,9 +727,18 @@ void ghost_t::set_mode(const mode_t m, const int mode_ms) noexcept {
         case mode_t::AWAY:
             break;
         case mode_t::LEVEL_SETUP:
+            // drop the previous level's state as after construction, making each level start a replayable restart point
+            mode_last = mode_t::AWAY;
+            live_counter_during_pacman_live = 0;
+            pellet_counter_active_ = false;
+            pellet_counter_ = 0;
+            current_speed_pct = 0.0f;
+            keyframei_.reset(get_frames_per_sec(), 0.0f, true /* nearest */);
+            sync_next_frame_cntr.reset( keyframei_.sync_frame_count(), true /* auto_reload */);
             atex = &get_tex();
             pos_ = home_pos;
             pos_.set_aligned_dir(keyframei_);
+            update_occupancy();
             current_dir = direction_t::LEFT;
             break;
         case mode_t::START:
@@ -690,6 +749,7 @@ void ghost_t::set_mode(const mode_t m, const int mode_ms) noexcept {
         case mode_t::HOME: {
             pos_ = home_pos;
             pos_.set_aligned_dir(keyframei_);
+            update_occupancy();
             current_dir = direction_t::LEFT;
             break;
         }
@@ -848,6 +908,7 @@ void ghost_t::tick() noexcept {
         return ( mode_t::LEAVE_HOME == mode_ || mode_t::PHANTOM == mode_ ) ?
                tile_t::WALL == tile : ( tile_t::WALL == tile || tile_t::GATE == tile );
     });
+    update_occupancy();
     if( pos_.intersects_i( global_maze->tunnel1_box() ) || pos_.intersects_i( global_maze->tunnel2_box() ) ) {
         set_speed(game_level_spec().ghost_speed_tunnel);
     } else {
@@ -894,29 +955,37 @@ void ghost_t::tick() noexcept {
     }
 }
 
-void ghost_t::draw(SDL_Renderer* rend) noexcept {
-    if( mode_t::AWAY == mode_ ) {
-        return;
-    }
-    if( pos_.intersects_i( pacman->freeze_box() ) ) {
+ghost_t::snapshot_t ghost_t::get_snapshot() const noexcept {
+    // the freeze box is applied by global_snapshot() via occupancy()
+    const bool visible = mode_t::AWAY != mode_;
+    return snapshot_t { .id=id_, .visible=visible, .has_target=is_scattering_or_chasing(),
+                        .tex=atex->handle(), .pos={ pos_.x_f(), pos_.y_f(), pos_.x_f(), pos_.y_f() }, .center=keyframei_.center(),
+                        .target_x=target_.x_f(), .target_y=target_.y_f() };
+}
+
+void ghost_t::draw(SDL_Renderer* rend, const snapshot_t& s, const float alpha) noexcept {
+    const tex_region_t tex = get_tex_region(s.tex);
+    if( !s.visible || !tex.is_valid() ) {
         return;
     }
+    float pos_x, pos_y;
+    s.pos.interpolate(alpha, pos_x, pos_y);
 
-    atex->draw2(rend, pos_.x_f()-keyframei_.center(), pos_.y_f()-keyframei_.center());
+    tex.draw2_f(rend, pos_x-s.center, pos_y-s.center);
 
     if( show_debug_gfx() ) {
         if( show_debug_gfx() ) {
             uint8_t r, g, b, a;
             SDL_GetRenderDrawColor(rend, &r, &g, &b, &a);
-            const int win_pixel_offset = ( win_pixel_width() - global_maze->pixel_width()*win_pixel_scale() ) / 2;
+            const viewport_t& vp = win_viewport();
             SDL_SetRenderDrawColor(rend,
-                                   rgb_color[ number( id() ) ][0],
-                                   rgb_color[ number( id() ) ][1],
-                                   rgb_color[ number( id() ) ][2], 255);
+                                   rgb_color[ number( s.id ) ][0],
+                                   rgb_color[ number( s.id ) ][1],
+                                   rgb_color[ number( s.id ) ][2], 255);
             // pos is on player center position
-            SDL_Rect bounds = { .x=win_pixel_offset + round_to_int( pos_.x_f() * global_maze->ppt_y() * win_pixel_scale() ) - ( atex->width()  * win_pixel_scale() ) / 2,
-                                .y=                   round_to_int( pos_.y_f() * global_maze->ppt_y() * win_pixel_scale() ) - ( atex->height() * win_pixel_scale() ) / 2,
-                                .w=atex->width()*win_pixel_scale(), .h=atex->height()*win_pixel_scale() };
+            SDL_Rect bounds = { .x=vp.offset_x() + vp.x_to_pixel( pos_x ) - vp.scaled( tex.width  ) / 2,
+                                .y=                vp.y_to_pixel( pos_y ) - vp.scaled( tex.height ) / 2,
+                                .w=vp.scaled( tex.width ), .h=vp.scaled( tex.height ) };
             SDL_RenderDrawRect(rend, &bounds);
             SDL_SetRenderDrawColor(rend, r, g, b, a);
         }
@@ -928,8 +997,8 @@ void ghost_t::draw(SDL_Renderer* rend) noexcept {
 //
 std::string ghost_t::pellet_counter_string() noexcept {
     std::string str = "global_pellet[on "+std::to_string(global_pellet_counter_active)+", ctr "+std::to_string(global_pellet_counter)+"], pellet[";
-    for(ghost_ref g : ghosts()) {
-        str += to_string(g->id_)+"[on "+std::to_string(g->pellet_counter_active_)+", ctr "+std::to_string(g->pellet_counter_)+"], ";
+    for(ghost_t& g : ghosts()) {
+        str += to_string(g.id_)+"[on "+std::to_string(g.pellet_counter_active_)+", ctr "+std::to_string(g.pellet_counter_)+"], ";
     }
     str += "]";
     return str;
@@ -939,21 +1008,17 @@ void ghost_t::notify_pellet_eaten() noexcept {
     if( global_pellet_counter_active ) {
         ++global_pellet_counter;
     } else {
-        ghost_ref blinky = ghost( personality_t::BLINKY );
-        ghost_ref pinky = ghost( personality_t::PINKY );
-        ghost_ref inky = ghost( personality_t::INKY );
-        ghost_ref clyde = ghost( personality_t::CLYDE );
-
-        // Blinky is always out
-        if( nullptr != pinky && pinky->at_home() && pinky->pellet_counter_active_ ) {
-            pinky->pellet_counter_++;
-        } else if( nullptr != inky && inky->at_home() && inky->pellet_counter_active_ ) {
-            inky->pellet_counter_++;
-        } else if( nullptr != clyde && clyde->at_home() && clyde->pellet_counter_active_ ) {
-            clyde->pellet_counter_++;
+        // Blinky is always out, otherwise the first ghost at home in release order counts
+        for(ghost_t& g : ghosts()) {
+            if( !g.traits_.start_outside && g.at_home() && g.pellet_counter_active_ ) {
+                g.pellet_counter_++;
+                break;
+            }
         }
-        if( nullptr != blinky ) {
-            blinky->set_mode_speed(); // in case he shall become Elroy
+        for(ghost_t& g : ghosts()) {
+            if( g.traits_.elroy ) {
+                g.set_mode_speed(); // in case he shall become Elroy
+            }
         }
     }
     global_pellet_time_left = game_level_spec().ghost_max_home_time_ms; // reset
@@ -974,10 +1039,10 @@ int ghost_t::pellet_counter() const noexcept {
 
 int ghost_t::pellet_counter_limit() const noexcept {
     if( pellet_counter_active_ ) {
-        return game_level_spec().ghost_pellet_counter_limit[ number(id_) ];
+        return game_level_spec().ghost_pellet_counter_limit[ traits_.pellet_limit_idx ] + traits_.pellet_limit_extra;
     }
     // global
-    return global_ghost_pellet_counter_limit[ number(id_) ];
+    return global_ghost_pellet_counter_limit[ traits_.pellet_limit_idx ] + traits_.pellet_limit_extra;
 }
 
 bool ghost_t::can_leave_home() noexcept {
@@ -992,12 +1057,12 @@ bool ghost_t::can_leave_home() noexcept {
         const int counter = pellet_counter();
         const int limit = pellet_counter_limit();
         if( counter >= limit ) {
-            if( global_pellet_counter_active && ghost_t::personality_t::CLYDE == id_ ) {
-                // re-enable local counter
+            if( global_pellet_counter_active && index_ == (int)ghosts().size()-1 ) {
+                // the last ghost, i.e. Clyde in the original, re-enables the local counters
                 global_pellet_counter_active = false;
                 global_pellet_counter = 0;
-                for(ghost_ref g : ghosts()) {
-                    g->pellet_counter_active_ = true;
+                for(ghost_t& g : ghosts()) {
+                    g.pellet_counter_active_ = true;
                 }
             }
             return true;
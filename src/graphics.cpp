@@ -25,11 +25,249 @@
 #include <pacman/graphics.hpp>
 #include <pacman/globals.hpp>
 
-#include <thread>
+#include <algorithm>
 #include <cstdio>
 
 static constexpr const bool DEBUG_LOG = false;
 
+//
+// viewport_t
+//
+
+void viewport_t::reset(const int win_width, const int win_height, const int maze_width, const int maze_height,
+                       const int ppt_x, const int ppt_y, const int scale) noexcept
+{
+    win_width_ = win_width;
+    win_height_ = win_height;
+    scale_ = scale;
+    ppt_x_ = ppt_x * scale;
+    ppt_y_ = ppt_y * scale;
+    width_ = maze_width;
+    height_ = maze_height;
+    offset_x_ = ( win_width - width_ * ppt_x_ ) / 2;
+    dxy_ = ppt_y_ / 3;
+
+    tile_x_.resize( std::max(0, width_) + 1 );
+    for(size_t i=0; i<tile_x_.size(); ++i) {
+        tile_x_[i] = (int)i * ppt_x_;
+    }
+    tile_y_.resize( std::max(0, height_) + 1 );
+    for(size_t i=0; i<tile_y_.size(); ++i) {
+        tile_y_[i] = (int)i * ppt_y_;
+    }
+    sub_x_.resize( sub_steps + 1 );
+    sub_y_.resize( sub_steps + 1 );
+    for(int i=0; i<=sub_steps; ++i) {
+        sub_x_[i] = round_to_int( (float)( i * ppt_x_ ) / (float)sub_steps );
+        sub_y_[i] = round_to_int( (float)( i * ppt_y_ ) / (float)sub_steps );
+    }
+}
+
+std::string viewport_t::toString() const noexcept {
+    return "viewport[win "+std::to_string(win_width_)+"x"+std::to_string(win_height_)+
+           ", offset "+std::to_string(offset_x_)+", scale "+std::to_string(scale_)+
+           ", maze "+std::to_string(pixel_width())+"x"+std::to_string(pixel_height())+"]";
+}
+
+//
+// tex_region_t and texture registry
+//
+
+/** Flat texture registry, index zero is the empty region of tex_handle_none */
+static std::vector<tex_region_t>& tex_registry() noexcept {
+    static std::vector<tex_region_t> registry = { tex_region_t { nullptr, 0, 0, 0, 0 } };
+    return registry;
+}
+
+tex_handle_t register_tex_region(SDL_Texture* tex, int x, int y, int w, int h) noexcept {
+    std::vector<tex_region_t>& r = tex_registry();
+    r.push_back( tex_region_t { tex, x, y, w, h } );
+    return static_cast<tex_handle_t>( r.size() - 1 );
+}
+
+tex_region_t get_tex_region(const tex_handle_t h) noexcept {
+    const std::vector<tex_region_t>& r = tex_registry();
+    return h < r.size() ? r[h] : r[tex_handle_none];
+}
+
+void clear_tex_registry() noexcept {
+    tex_registry().resize(1);
+}
+
+//
+// pre-scaled texture atlas
+//
+
+struct scaled_tex_atlas_t {
+    SDL_Texture* src;
+    SDL_Texture* scaled;
+    int scale;
+};
+
+static std::vector<scaled_tex_atlas_t> scaled_tex_atlases;
+
+static void destroy_scaled(scaled_tex_atlas_t& a) noexcept {
+    if( nullptr != a.scaled ) {
+        SDL_DestroyTexture(a.scaled);
+    }
+    a.scaled = nullptr;
+    a.scale = 1;
+}
+
+void add_scaled_tex_atlas(SDL_Texture* tex) noexcept {
+    if( nullptr != tex ) {
+        scaled_tex_atlases.push_back( scaled_tex_atlas_t { tex, nullptr, 1 } );
+    }
+}
+
+/**
+ * Scales the given region of the source into the same region of the scaled atlas,
+ * using the staging target padded by one pixel replicating the region's edges.
+ *
+ * Filtering at the region's border hence samples its own edge pixels instead of its neighbors in the atlas.
+ */
+static void rescale_region(SDL_Renderer* rend, SDL_Texture* src, SDL_Texture* staging, SDL_Texture* scaled,
+                           const tex_region_t& r, const int scale) noexcept
+{
+    const int x=r.x, y=r.y, w=r.width, h=r.height;
+    SDL_SetRenderTarget(rend, staging);
+    SDL_RenderClear(rend);
+    const SDL_Rect copies[][2] = {
+        { { x,     y,     w, h }, { 1,   1,   w, h } }, // region
+        { { x,     y,     w, 1 }, { 1,   0,   w, 1 } }, // top
+        { { x,     y+h-1, w, 1 }, { 1,   h+1, w, 1 } }, // bottom
+        { { x,     y,     1, h }, { 0,   1,   1, h } }, // left
+        { { x+w-1, y,     1, h }, { w+1, 1,   1, h } }, // right
+        { { x,     y,     1, 1 }, { 0,   0,   1, 1 } }, // corners
+        { { x+w-1, y,     1, 1 }, { w+1, 0,   1, 1 } },
+        { { x,     y+h-1, 1, 1 }, { 0,   h+1, 1, 1 } },
+        { { x+w-1, y+h-1, 1, 1 }, { w+1, h+1, 1, 1 } } };
+    for(const SDL_Rect (&c)[2] : copies) {
+        SDL_RenderCopy(rend, src, &c[0], &c[1]);
+    }
+    SDL_SetRenderTarget(rend, scaled);
+    const SDL_Rect clip = { x*scale, y*scale, w*scale, h*scale };
+    const SDL_Rect padded_src = { 0, 0, w+2, h+2 };
+    const SDL_Rect padded_dest = { (x-1)*scale, (y-1)*scale, (w+2)*scale, (h+2)*scale };
+    SDL_RenderSetClipRect(rend, &clip);
+    SDL_RenderCopy(rend, staging, &padded_src, &padded_dest);
+    SDL_RenderSetClipRect(rend, NULL);
+}
+
+void rescale_tex_atlases(SDL_Renderer* rend, const int scale) noexcept {
+    const bool use_targets = 1 < scale && SDL_TRUE == SDL_RenderTargetSupported(rend);
+    SDL_Texture* const old_target = SDL_GetRenderTarget(rend);
+    uint8_t old_r, old_g, old_b, old_a;
+    SDL_GetRenderDrawColor(rend, &old_r, &old_g, &old_b, &old_a);
+    SDL_SetRenderDrawColor(rend, 0, 0, 0, 0);
+
+    for(scaled_tex_atlas_t& a : scaled_tex_atlases) {
+        destroy_scaled(a);
+        if( !use_targets ) {
+            continue;
+        }
+        int width = 0, height = 0;
+        SDL_QueryTexture(a.src, NULL, NULL, &width, &height);
+        a.scaled = SDL_CreateTexture(rend, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width*scale, height*scale);
+        if( nullptr == a.scaled ) {
+            log_printf("rescale_tex_atlases: Error creating %d x %d target: %s\n", width*scale, height*scale, SDL_GetError());
+            continue;
+        }
+        // distinct registered regions within this atlas
+        std::vector<tex_region_t> regions;
+        int max_w = 0, max_h = 0;
+        for(const tex_region_t& r : tex_registry()) {
+            if( r.tex == a.src && 0 < r.width && 0 < r.height &&
+                regions.end() == std::find_if(regions.begin(), regions.end(), [&](const tex_region_t& o) {
+                    return o.x == r.x && o.y == r.y && o.width == r.width && o.height == r.height; }) )
+            {
+                regions.push_back(r);
+                max_w = std::max(max_w, r.width);
+                max_h = std::max(max_h, r.height);
+            }
+        }
+        SDL_Texture* staging = regions.size() > 0 ?
+                SDL_CreateTexture(rend, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, max_w+2, max_h+2) : nullptr;
+
+        // Copy the source including its alpha channel, filtered once with the source's scale quality
+        SDL_BlendMode src_blend = SDL_BLENDMODE_BLEND;
+        SDL_GetTextureBlendMode(a.src, &src_blend);
+        SDL_SetTextureBlendMode(a.src, SDL_BLENDMODE_NONE);
+        SDL_SetRenderTarget(rend, a.scaled);
+        SDL_RenderClear(rend);
+        // the whole atlas covers unregistered areas, e.g. a single image texture
+        SDL_RenderCopy(rend, a.src, NULL, NULL);
+        if( nullptr != staging ) {
+            SDL_SetTextureBlendMode(staging, SDL_BLENDMODE_NONE);
+            for(const tex_region_t& r : regions) {
+                rescale_region(rend, a.src, staging, a.scaled, r, scale);
+            }
+            SDL_DestroyTexture(staging);
+        } else if( regions.size() > 0 ) {
+            log_printf("rescale_tex_atlases: Error creating %d x %d staging target: %s\n", max_w+2, max_h+2, SDL_GetError());
+        }
+        SDL_SetTextureBlendMode(a.src, src_blend);
+        SDL_SetTextureBlendMode(a.scaled, src_blend);
+        a.scale = scale;
+        if( DEBUG_LOG ) {
+            log_printf("rescale_tex_atlases: %d x %d * %d, %zu regions\n", width, height, scale, regions.size());
+        }
+    }
+    SDL_SetRenderTarget(rend, old_target);
+    SDL_SetRenderDrawColor(rend, old_r, old_g, old_b, old_a);
+}
+
+void clear_scaled_tex_atlases() noexcept {
+    for(scaled_tex_atlas_t& a : scaled_tex_atlases) {
+        destroy_scaled(a);
+    }
+    scaled_tex_atlases.clear();
+}
+
+/**
+ * Copies the given source rectangle of the texture to dest,
+ * using the pre-scaled atlas 1:1 if available for the destination's scale.
+ */
+static void render_copy(SDL_Renderer* rend, SDL_Texture* tex, const SDL_Rect& src, const SDL_Rect& dest, const int scale) noexcept {
+    for(const scaled_tex_atlas_t& a : scaled_tex_atlases) {
+        if( a.src == tex ) {
+            if( nullptr != a.scaled && a.scale == scale ) {
+                SDL_Rect src_scaled = { .x=src.x*scale, .y=src.y*scale, .w=dest.w, .h=dest.h };
+                SDL_RenderCopy(rend, a.scaled, &src_scaled, &dest);
+                return;
+            }
+            break;
+        }
+    }
+    SDL_RenderCopy(rend, tex, &src, &dest);
+}
+
+void tex_region_t::draw(SDL_Renderer* rend, const float x_pos, const float y_pos) const noexcept {
+    if( nullptr != tex ) {
+        const viewport_t& vp = win_viewport();
+        SDL_Rect src = { .x=x, .y=y, .w=width, .h=height};
+        SDL_Rect dest = { .x=vp.offset_x() + vp.x_to_pixel(x_pos),
+                          .y=vp.y_to_pixel(y_pos),
+                          .w=vp.scaled(width), .h=vp.scaled(height) };
+        render_copy(rend, tex, src, dest, vp.scale());
+    }
+}
+
+void tex_region_t::draw2_f(SDL_Renderer* rend, const float x_pos, const float y_pos) const noexcept {
+    if( nullptr != tex ) {
+        const viewport_t& vp = win_viewport();
+        SDL_Rect src = { .x=x, .y=y, .w=width, .h=height};
+        SDL_Rect dest = { .x=vp.offset_x() + vp.x_to_pixel(x_pos) - vp.dxy(),
+                          .y=vp.y_to_pixel(y_pos) - vp.dxy(),
+                          .w=vp.scaled(width), .h=vp.scaled(height) };
+        render_copy(rend, tex, src, dest, vp.scale());
+    }
+}
+
+std::string tex_region_t::toString() const noexcept {
+    return std::to_string(x)+"/"+std::to_string(y) + " " + std::to_string(width)+"x"+std::to_string(height) + ", valid " + std::to_string(is_valid());
+}
+
 //
 // texture_t
 //
@@ -87,8 +325,7 @@ void texture_t::destroy() noexcept {
 void texture_t::draw_scaled_dimpos(SDL_Renderer* rend, const int x_pos, const int y_pos) noexcept {
     if( nullptr != tex_ ) {
         SDL_Rect src = { .x=x_, .y=y_, .w=width_, .h=height_};
-        const int win_pixel_offset = ( win_pixel_width() - global_maze->pixel_width()*win_pixel_scale() ) / 2;
-        SDL_Rect dest = { .x=win_pixel_offset + x_pos,
+        SDL_Rect dest = { .x=win_viewport().offset_x() + x_pos,
                           .y=y_pos,
                           .w=width_, .h=height_ };
         SDL_RenderCopy(rend, tex_, &src, &dest);
@@ -96,55 +333,39 @@ void texture_t::draw_scaled_dimpos(SDL_Renderer* rend, const int x_pos, const in
 }
 void texture_t::draw_scaled_dim(SDL_Renderer* rend, const int x_pos, const int y_pos) noexcept {
     if( nullptr != tex_ ) {
+        const viewport_t& vp = win_viewport();
         SDL_Rect src = { .x=x_, .y=y_, .w=width_, .h=height_};
-        const int win_pixel_offset = ( win_pixel_width() - global_maze->pixel_width()*win_pixel_scale() ) / 2;
-        SDL_Rect dest = { .x=win_pixel_offset + ( global_maze->x_to_pixel(x_pos, win_pixel_scale()) ),
-                          .y=global_maze->y_to_pixel(y_pos, win_pixel_scale()),
+        SDL_Rect dest = { .x=vp.offset_x() + vp.x_to_pixel(x_pos),
+                          .y=vp.y_to_pixel(y_pos),
                           .w=width_, .h=height_ };
         SDL_RenderCopy(rend, tex_, &src, &dest);
     }
 }
 void texture_t::draw(SDL_Renderer* rend, const int x_pos, const int y_pos) noexcept {
     if( nullptr != tex_ ) {
+        const viewport_t& vp = win_viewport();
         SDL_Rect src = { .x=x_, .y=y_, .w=width_, .h=height_};
-        const int win_pixel_offset = ( win_pixel_width() - global_maze->pixel_width()*win_pixel_scale() ) / 2;
-        SDL_Rect dest = { .x=win_pixel_offset + ( global_maze->x_to_pixel(x_pos, win_pixel_scale()) ),
-                          .y=global_maze->y_to_pixel(y_pos, win_pixel_scale()),
-                          .w=width_*win_pixel_scale(), .h=height_*win_pixel_scale() };
-        SDL_RenderCopy(rend, tex_, &src, &dest);
+        SDL_Rect dest = { .x=vp.offset_x() + vp.x_to_pixel(x_pos),
+                          .y=vp.y_to_pixel(y_pos),
+                          .w=vp.scaled(width_), .h=vp.scaled(height_) };
+        render_copy(rend, tex_, src, dest, vp.scale());
     }
 }
 void texture_t::draw2_i(SDL_Renderer* rend, const int x_pos, const int y_pos) noexcept {
     if( nullptr != tex_ ) {
+        const viewport_t& vp = win_viewport();
         SDL_Rect src = { .x=x_, .y=y_, .w=width_, .h=height_};
-        const int win_pixel_offset = ( win_pixel_width() - global_maze->pixel_width()*win_pixel_scale() ) / 2;
-        const int dxy = ( ( global_maze->ppt_y() * win_pixel_scale() ) / 3 );
-        SDL_Rect dest = { .x=win_pixel_offset + ( ( x_pos * global_maze->ppt_x() * win_pixel_scale() ) - dxy ),
-                          .y= ( ( y_pos * global_maze->ppt_y() * win_pixel_scale() ) - dxy ),
-                          .w=width_*win_pixel_scale(), .h=height_*win_pixel_scale() };
-        SDL_RenderCopy(rend, tex_, &src, &dest);
+        SDL_Rect dest = { .x=vp.offset_x() + vp.x_to_pixel(x_pos) - vp.dxy(),
+                          .y=vp.y_to_pixel(y_pos) - vp.dxy(),
+                          .w=vp.scaled(width_), .h=vp.scaled(height_) };
+        render_copy(rend, tex_, src, dest, vp.scale());
     }
 }
 void texture_t::draw(SDL_Renderer* rend, const float x_pos, const float y_pos) noexcept {
-    if( nullptr != tex_ ) {
-        SDL_Rect src = { .x=x_, .y=y_, .w=width_, .h=height_};
-        const int win_pixel_offset = ( win_pixel_width() - global_maze->pixel_width()*win_pixel_scale() ) / 2;
-        SDL_Rect dest = { .x=win_pixel_offset + global_maze->x_to_pixel(x_pos, win_pixel_scale()),
-                          .y=global_maze->y_to_pixel(y_pos, win_pixel_scale()),
-                          .w=width_*win_pixel_scale(), .h=height_*win_pixel_scale() };
-        SDL_RenderCopy(rend, tex_, &src, &dest);
-    }
+    region().draw(rend, x_pos, y_pos);
 }
 void texture_t::draw2_f(SDL_Renderer* rend, const float x_pos, const float y_pos) noexcept {
-    if( nullptr != tex_ ) {
-        SDL_Rect src = { .x=x_, .y=y_, .w=width_, .h=height_};
-        const int win_pixel_offset = ( win_pixel_width() - global_maze->pixel_width()*win_pixel_scale() ) / 2;
-        const int dxy = ( ( global_maze->ppt_y() * win_pixel_scale() ) / 3 );
-        SDL_Rect dest = { .x=win_pixel_offset + ( round_to_int( x_pos * global_maze->ppt_x() * win_pixel_scale() ) - dxy ),
-                          .y= ( round_to_int( y_pos * global_maze->ppt_y() * win_pixel_scale() ) - dxy ),
-                          .w=width_*win_pixel_scale(), .h=height_*win_pixel_scale() };
-        SDL_RenderCopy(rend, tex_, &src, &dest);
-    }
+    region().draw2_f(rend, x_pos, y_pos);
 }
 
 std::string texture_t::toString() const noexcept {
@@ -201,17 +422,33 @@ int add_sub_textures(std::vector<std::shared_ptr<texture_t>>& storage, SDL_Rende
     return storage.size() - size_start;
 }
 
+int add_sub_textures(std::vector<tex_handle_t>& storage, const std::shared_ptr<texture_t>& global_texture,
+                     int x_off, int y_off, int w, int h, const std::vector<tex_sub_coord_t>& tex_positions) noexcept
+{
+    const size_t size_start = storage.size();
+
+    for(tex_sub_coord_t p : tex_positions) {
+        const int x = x_off+p.x;
+        const int y = y_off+p.y;
+        if( 0 <= x && 0 <= y && x+w <= global_texture->width() && y+h <= global_texture->height() ) {
+            storage.push_back( register_tex_region(global_texture->sdl_texture(), x, y, w, h) );
+        } else {
+            storage.push_back( tex_handle_none );
+        }
+        if( DEBUG_LOG ) {
+            log_printf("add_sub_textures: handle %u [%d][%d]: %s\n", storage[ storage.size() - 1 ], x, y, get_tex_region( storage[ storage.size() - 1 ] ).toString().c_str());
+        }
+    }
+    return storage.size() - size_start;
+}
+
 //
 // animtex_t
 //
 
-animtex_t::animtex_t(std::string name, int ms_per_atex, const std::vector<std::shared_ptr<texture_t>>& textures) noexcept
-: name_( name )
+animtex_t::animtex_t(std::string name, int ms_per_atex, const std::vector<tex_handle_t>& handles) noexcept
+: name_( name ), handles_( handles )
 {
-    for(size_t i=0; i<textures.size(); ++i) {
-        texture_t& o = *textures[i];
-        textures_.push_back( std::make_shared<texture_t>(o.sdl_texture(), o.x(), o.y(), o.width(), o.height(), false /* owner */) );
-    }
     ms_per_atex_ = ms_per_atex;
     atex_ms_left_ = 0;
     animation_index_ = 0;
@@ -222,7 +459,8 @@ animtex_t::animtex_t(std::string name, SDL_Renderer* rend, int ms_per_atex, cons
 : name_( name )
 {
     for(size_t i=0; i<filenames.size(); ++i) {
-        textures_.push_back( std::make_shared<texture_t>(rend, filenames[i]) );
+        owned_.push_back( std::make_shared<texture_t>(rend, filenames[i]) );
+        handles_.push_back( owned_[i]->register_region() );
     }
     ms_per_atex_ = ms_per_atex;
     atex_ms_left_ = 0;
@@ -233,7 +471,10 @@ animtex_t::animtex_t(std::string name, SDL_Renderer* rend, int ms_per_atex, cons
 animtex_t::animtex_t(std::string name, SDL_Renderer* rend, int ms_per_atex, const std::string& filename, int w, int h, int x_off) noexcept
 : name_( name )
 {
-    add_sub_textures(textures_, rend, filename, w, h, x_off);
+    add_sub_textures(owned_, rend, filename, w, h, x_off);
+    for(size_t i=0; i<owned_.size(); ++i) {
+        handles_.push_back( owned_[i]->register_region() );
+    }
     ms_per_atex_ = ms_per_atex;
     atex_ms_left_ = 0;
     animation_index_ = 0;
@@ -244,7 +485,7 @@ animtex_t::animtex_t(std::string name, SDL_Renderer* rend, int ms_per_atex, cons
                      int x_off, int y_off, int w, int h, const std::vector<tex_sub_coord_t>& tex_positions) noexcept
 : name_(name)
 {
-    add_sub_textures(textures_, rend, global_texture, x_off, y_off, w, h, tex_positions);
+    add_sub_textures(handles_, global_texture, x_off, y_off, w, h, tex_positions);
     ms_per_atex_ = ms_per_atex;
     atex_ms_left_ = 0;
     animation_index_ = 0;
@@ -252,10 +493,11 @@ animtex_t::animtex_t(std::string name, SDL_Renderer* rend, int ms_per_atex, cons
 }
 
 void animtex_t::destroy() noexcept {
-    for(size_t i=0; i<textures_.size(); ++i) {
-        textures_[i]->destroy();
+    for(size_t i=0; i<owned_.size(); ++i) {
+        owned_[i]->destroy();
     }
-    textures_.clear();
+    owned_.clear();
+    handles_.clear();
 }
 
 void animtex_t::pause(bool enable) noexcept {
@@ -277,8 +519,8 @@ void animtex_t::tick() noexcept {
         }
         if( 0 == atex_ms_left_ ) {
             atex_ms_left_ = ms_per_atex_;
-            if( textures_.size() > 0 ) {
-                animation_index_ = ( animation_index_ + 1 ) % textures_.size();
+            if( handles_.size() > 0 ) {
+                animation_index_ = ( animation_index_ + 1 ) % handles_.size();
             } else {
                 animation_index_ = 0;
             }
@@ -286,26 +528,18 @@ void animtex_t::tick() noexcept {
     }
 }
 
-void animtex_t::draw(SDL_Renderer* rend, const float x, const float y) noexcept {
-    std::shared_ptr<texture_t> tex = texture();
-    if( nullptr != tex ) {
-        tex->draw(rend, x, y);
-    }
+void animtex_t::draw(SDL_Renderer* rend, const float x, const float y) const noexcept {
+    texture().draw(rend, x, y);
 }
 
-void animtex_t::draw2(SDL_Renderer* rend, const float x, const float y) noexcept {
-    std::shared_ptr<texture_t> tex = texture();
-    if( nullptr != tex ) {
-        tex->draw2_f(rend, x, y);
-    }
+void animtex_t::draw2(SDL_Renderer* rend, const float x, const float y) const noexcept {
+    texture().draw2_f(rend, x, y);
 }
 
 std::string animtex_t::toString() const noexcept {
-    std::shared_ptr<const texture_t> tex = texture();
-    std::string tex_s = nullptr != tex ? tex->toString() : "null";
     return name_+"[anim "+std::to_string(atex_ms_left_)+"/"+std::to_string(ms_per_atex_)+
-            " ms, paused "+std::to_string(paused_)+", idx "+std::to_string(animation_index_)+"/"+std::to_string(textures_.size())+
-            ", textures["+tex_s+"]]";
+            " ms, paused "+std::to_string(paused_)+", idx "+std::to_string(animation_index_)+"/"+std::to_string(handles_.size())+
+            ", textures["+texture().toString()+"]]";
 }
 
 void text_texture_t::draw(SDL_Renderer* rend) noexcept {
@@ -421,11 +655,12 @@ text_texture_ref draw_text_scaled(SDL_Renderer* rend, TTF_Font* font, const std:
 void draw_box(SDL_Renderer* rend, bool filled, int x_pixel_offset, int y_pixel_offset,
               float x, float y, float width, float height) noexcept
 {
+    const viewport_t& vp = win_viewport();
     SDL_Rect bounds = {
-            .x=x_pixel_offset + global_maze->x_to_pixel(x, win_pixel_scale()),
-            .y=y_pixel_offset + global_maze->y_to_pixel(y, win_pixel_scale()),
-            .w=global_maze->x_to_pixel(width, win_pixel_scale()),
-            .h=global_maze->y_to_pixel(height, win_pixel_scale())};
+            .x=x_pixel_offset + vp.x_to_pixel(x),
+            .y=y_pixel_offset + vp.y_to_pixel(y),
+            .w=vp.x_to_pixel(width),
+            .h=vp.y_to_pixel(height)};
     if( filled ) {
         SDL_RenderFillRect(rend, &bounds);
     } else {
@@ -433,73 +668,150 @@ void draw_box(SDL_Renderer* rend, bool filled, int x_pixel_offset, int y_pixel_o
     }
 }
 
+//
+// draw_line(..) frame scoped vertex buffer
+//
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    #define LINE_USE_RENDER_GEOMETRY 1
+#else
+    #define LINE_USE_RENDER_GEOMETRY 0
+#endif
+
+/** A queued line in window pixel space, see draw_line() and flush_lines(). */
+struct line_seg_t {
+    SDL_Color color;
+    int x1, y1, x2, y2;
+    int width;
+};
+
+/** Initial line capacity, covering the debug grid and all ghost target rays. */
+static constexpr const size_t line_capacity = 256;
+
+/**
+ * Frame scoped line storage, reserved once.
+ *
+ * Buffers are only cleared after each flush_lines(), retaining their capacity,
+ * hence no heap traffic occurs while drawing lines.
+ */
+static std::vector<line_seg_t>& line_segments() noexcept {
+    static std::vector<line_seg_t> segs = []() {
+        std::vector<line_seg_t> v;
+        v.reserve(line_capacity);
+        return v;
+    }();
+    return segs;
+}
+
+#if LINE_USE_RENDER_GEOMETRY
+static std::vector<SDL_Vertex>& line_vertices() noexcept {
+    static std::vector<SDL_Vertex> verts = []() {
+        std::vector<SDL_Vertex> v;
+        v.reserve(line_capacity * 6);
+        return v;
+    }();
+    return verts;
+}
+#else
+static std::vector<SDL_Point>& line_points() noexcept {
+    static std::vector<SDL_Point> points = []() {
+        std::vector<SDL_Point> v;
+        v.reserve(64);
+        return v;
+    }();
+    return points;
+}
+#endif
+
 void draw_line(SDL_Renderer* rend, int pixel_width_scaled, int x_pixel_offset, int y_pixel_offset,
                float x1, float y1, float x2, float y2) noexcept
 {
     if( 0 >= pixel_width_scaled ) {
         return;
     }
-    const int x1_i = x_pixel_offset + global_maze->x_to_pixel( x1, win_pixel_scale());
-    const int y1_i = y_pixel_offset + global_maze->y_to_pixel( y1, win_pixel_scale());
-    const int x2_i = x_pixel_offset + global_maze->x_to_pixel( x2, win_pixel_scale());
-    const int y2_i = y_pixel_offset + global_maze->y_to_pixel( y2, win_pixel_scale());
-    const int d_extra = pixel_width_scaled - 1;
-    if( 0 == d_extra ) {
-        SDL_RenderDrawLine(rend, x1_i, y1_i, x2_i, y2_i);
+    line_seg_t seg;
+    SDL_GetRenderDrawColor(rend, &seg.color.r, &seg.color.g, &seg.color.b, &seg.color.a);
+    const viewport_t& vp = win_viewport();
+    seg.x1 = x_pixel_offset + vp.x_to_pixel(x1);
+    seg.y1 = y_pixel_offset + vp.y_to_pixel(y1);
+    seg.x2 = x_pixel_offset + vp.x_to_pixel(x2);
+    seg.y2 = y_pixel_offset + vp.y_to_pixel(y2);
+    seg.width = pixel_width_scaled;
+    line_segments().push_back(seg);
+}
+
+void flush_lines(SDL_Renderer* rend) noexcept {
+    std::vector<line_seg_t>& segs = line_segments();
+    if( 0 == segs.size() ) {
         return;
     }
-    const float d_x = std::abs( x1_i - x2_i );
-    const float d_y = std::abs( y1_i - y2_i );
-
-    // Create a polygon of connected dots, aka poly-line
-    const int c_l = -1 * ( d_extra / 2 + d_extra % 2 ); // gets the remainder
-    const int c_r =        d_extra / 2;
-    std::vector<SDL_Point> points;
-    bool first_of_two = true;
-    for(int i=c_l; i<=c_r; ++i) {
-        int ix, iy; // rough and simply thickness delta picking
-        if( d_y > d_x ) {
-            ix = i;
-            iy = 0;
-        } else {
-            ix = 0;
-            iy = i;
-        }
-        if( first_of_two ) {
-            points.push_back( SDL_Point { x1_i+ix, y1_i+iy } );
-            points.push_back( SDL_Point { x2_i+ix, y2_i+iy } );
-            first_of_two = false;
+#if LINE_USE_RENDER_GEOMETRY
+    // One quad (two triangles) per line, all lines rendered with a single draw call
+    std::vector<SDL_Vertex>& verts = line_vertices();
+    for(const line_seg_t& s : segs) {
+        const int d_extra = s.width - 1;
+        const int c_l = -1 * ( d_extra / 2 + d_extra % 2 ); // gets the remainder
+        const int c_r =        d_extra / 2 + 1;             // exclusive
+        int ix_l, iy_l, ix_r, iy_r; // rough and simply thickness delta picking
+        if( std::abs( s.y1 - s.y2 ) > std::abs( s.x1 - s.x2 ) ) {
+            ix_l = c_l; ix_r = c_r; iy_l = 0; iy_r = 0;
         } else {
-            points.push_back( SDL_Point { x2_i+ix, y2_i+iy } );
-            points.push_back( SDL_Point { x1_i+ix, y1_i+iy } );
-            first_of_two = true;
+            ix_l = 0; ix_r = 0; iy_l = c_l; iy_r = c_r;
         }
-    }
-    const int err = SDL_RenderDrawLines(rend, points.data(), points.size());
+        const SDL_Vertex v0 = { { (float)(s.x1+ix_l), (float)(s.y1+iy_l) }, s.color, { 0, 0 } };
+        const SDL_Vertex v1 = { { (float)(s.x1+ix_r), (float)(s.y1+iy_r) }, s.color, { 0, 0 } };
+        const SDL_Vertex v2 = { { (float)(s.x2+ix_r), (float)(s.y2+iy_r) }, s.color, { 0, 0 } };
+        const SDL_Vertex v3 = { { (float)(s.x2+ix_l), (float)(s.y2+iy_l) }, s.color, { 0, 0 } };
+        verts.push_back(v0); verts.push_back(v1); verts.push_back(v2);
+        verts.push_back(v0); verts.push_back(v2); verts.push_back(v3);
+    }
+    const int err = SDL_RenderGeometry(rend, nullptr, verts.data(), (int)verts.size(), nullptr, 0);
     if( false ) {
-        log_printf("Poly-Line thick_p %d, %d lines, d %.4f/%.4f, err %d, %s\n", pixel_width_scaled, points.size()/2, d_x, d_y, err, SDL_GetError());
+        log_printf("Lines: %zd lines, %zd vertices, err %d, %s\n", segs.size(), verts.size(), err, SDL_GetError());
+    }
+    verts.clear();
+#else
+    // SDL < 2.0.18: One poly-line draw call per line, reusing the point buffer
+    uint8_t r, g, b, a;
+    SDL_GetRenderDrawColor(rend, &r, &g, &b, &a);
+    std::vector<SDL_Point>& points = line_points();
+    for(const line_seg_t& s : segs) {
+        SDL_SetRenderDrawColor(rend, s.color.r, s.color.g, s.color.b, s.color.a);
+        const int d_extra = s.width - 1;
+        if( 0 == d_extra ) {
+            SDL_RenderDrawLine(rend, s.x1, s.y1, s.x2, s.y2);
+            continue;
+        }
+        const int d_x = std::abs( s.x1 - s.x2 );
+        const int d_y = std::abs( s.y1 - s.y2 );
+
+        // Create a polygon of connected dots, aka poly-line
+        const int c_l = -1 * ( d_extra / 2 + d_extra % 2 ); // gets the remainder
+        const int c_r =        d_extra / 2;
+        bool first_of_two = true;
+        for(int i=c_l; i<=c_r; ++i) {
+            int ix, iy; // rough and simply thickness delta picking
+            if( d_y > d_x ) {
+                ix = i;
+                iy = 0;
+            } else {
+                ix = 0;
+                iy = i;
+            }
+            if( first_of_two ) {
+                points.push_back( SDL_Point { s.x1+ix, s.y1+iy } );
+                points.push_back( SDL_Point { s.x2+ix, s.y2+iy } );
+                first_of_two = false;
+            } else {
+                points.push_back( SDL_Point { s.x2+ix, s.y2+iy } );
+                points.push_back( SDL_Point { s.x1+ix, s.y1+iy } );
+                first_of_two = true;
+            }
+        }
+        SDL_RenderDrawLines(rend, points.data(), (int)points.size());
+        points.clear();
     }
-}
-
-static std::atomic<int> active_threads = 0;
-
-static void store_surface(SDL_Surface *sshot, char* fname) noexcept {
-    active_threads++;
-    if( false ) {
-        fprintf(stderr, "XXX: %d: %s\n", active_threads.load(), fname);
-    }
-    SDL_SaveBMP(sshot, fname);
-    free(fname);
-    SDL_UnlockSurface(sshot);
-    SDL_FreeSurface(sshot);
-    active_threads--;
-}
-
-void save_snapshot(SDL_Renderer* rend, const int width, const int height, const std::string& fname) noexcept {
-    SDL_Surface *sshot = SDL_CreateRGBSurface(0, width, height, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
-    SDL_LockSurface(sshot);
-    SDL_RenderReadPixels(rend, NULL, SDL_PIXELFORMAT_ARGB8888, sshot->pixels, sshot->pitch);
-    char * fname2 = strdup(fname.c_str());
-    std::thread t(&store_surface, sshot, fname2);
-    t.detach();
+    SDL_SetRenderDrawColor(rend, r, g, b, a);
+#endif
+    segs.clear();
 }
@@ -0,0 +1,171 @@
+/*
+ * Author: Sven Gothel <sgothel@jausoft.com> and Svenson Han Gothel
+ * Copyright (c) 2022 Gothel Software e.K.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <pacman/hot_reload.hpp>
+#include <pacman/utils.hpp>
+
+#include <cstring>
+#include <cinttypes>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+//
+// hot_reload_t
+//
+
+hot_reload_t::hot_reload_t(const std::string& maze_fname_, const std::string& level_spec_fname_) noexcept
+: maze_fname(maze_fname_), level_spec_fname(level_spec_fname_),
+  inotify_fd(-1), running(false), pending(false)
+{ }
+
+bool hot_reload_t::add_watch(const std::string& fname, const bool is_maze) noexcept {
+    const size_t sep = fname.find_last_of('/');
+    const std::string dir = std::string::npos == sep ? "." : fname.substr(0, std::max<size_t>(1, sep));
+    const std::string name = std::string::npos == sep ? fname : fname.substr(sep+1);
+    // editors often write a new file and rename it, hence watch the directory
+    const int wd = inotify_add_watch(inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if( 0 > wd ) {
+        log_printf("Hot reload: Error: watch %s: %s\n", dir.c_str(), strerror(errno));
+        return false;
+    }
+    watches.push_back( { wd, dir, name, is_maze } );
+    log_printf("Hot reload: watching %s\n", fname.c_str());
+    return true;
+}
+
+bool hot_reload_t::start() noexcept {
+    if( running ) {
+        return true;
+    }
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if( 0 > inotify_fd ) {
+        log_printf("Hot reload: Error: inotify: %s\n", strerror(errno));
+        return false;
+    }
+    if( !add_watch(maze_fname, true) || ( level_spec_fname.size() > 0 && !add_watch(level_spec_fname, false) ) ) {
+        ::close(inotify_fd);
+        inotify_fd = -1;
+        watches.clear();
+        return false;
+    }
+    running = true;
+    worker = std::thread(&hot_reload_t::run, this);
+    return true;
+}
+
+void hot_reload_t::stop() noexcept {
+    running = false;
+    if( worker.joinable() ) {
+        worker.join();
+    }
+    if( 0 <= inotify_fd ) {
+        ::close(inotify_fd);
+        inotify_fd = -1;
+    }
+    watches.clear();
+}
+
+void hot_reload_t::run() noexcept {
+    alignas(struct inotify_event) char buffer[4096];
+    bool dirty_maze = false, dirty_level_spec = false;
+    uint64_t last_event_ms = 0;
+
+    while( running ) {
+        struct pollfd pfd { inotify_fd, POLLIN, 0 };
+        if( 0 < ::poll(&pfd, 1, debounce_ms) ) {
+            ssize_t len;
+            while( 0 < ( len = ::read(inotify_fd, buffer, sizeof(buffer)) ) ) {
+                for(ssize_t i=0; i < len; ) {
+                    const struct inotify_event* ev = reinterpret_cast<const struct inotify_event*>(&buffer[i]);
+                    if( 0 < ev->len ) {
+                        for(const watch_t& w : watches) {
+                            if( w.wd == ev->wd && w.name == ev->name ) {
+                                if( w.is_maze ) {
+                                    dirty_maze = true;
+                                } else {
+                                    dirty_level_spec = true;
+                                }
+                                last_event_ms = getCurrentMilliseconds();
+                                if( DEBUG ) {
+                                    log_printf("Hot reload: event 0x%x on %s/%s\n", ev->mask, w.dir.c_str(), ev->name);
+                                }
+                            }
+                        }
+                    }
+                    i += sizeof(struct inotify_event) + ev->len;
+                }
+            }
+        }
+        if( ( dirty_maze || dirty_level_spec ) && getCurrentMilliseconds() - last_event_ms >= (uint64_t)debounce_ms ) {
+            reload(dirty_maze, dirty_level_spec);
+            dirty_maze = false;
+            dirty_level_spec = false;
+        }
+    }
+}
+
+void hot_reload_t::reload(const bool maze, const bool level_spec) noexcept {
+    if( maze ) {
+        const uint64_t t0 = getCurrentMilliseconds();
+        std::unique_ptr<maze_t> m = std::make_unique<maze_t>(maze_fname);
+        if( m->is_ok() ) {
+            log_printf("Hot reload: maze %s rebuilt in %" PRIu64 " ms, pending until next level\n",
+                    maze_fname.c_str(), getCurrentMilliseconds() - t0);
+            std::lock_guard<std::mutex> lock(mtx_pending);
+            pending_maze = std::move(m);
+            pending = true;
+        } else {
+            log_printf("Hot reload: Error: maze %s: %s\n", maze_fname.c_str(), m->toString().c_str());
+        }
+    }
+    if( level_spec ) {
+        std::vector<game_level_spec_t> spec;
+        if( load_level_spec(level_spec_fname, spec) ) {
+            log_printf("Hot reload: level spec %s with %zu levels, pending until next level\n",
+                    level_spec_fname.c_str(), spec.size());
+            std::lock_guard<std::mutex> lock(mtx_pending);
+            pending_level_spec = std::move(spec);
+            pending = true;
+        }
+    }
+}
+
+std::unique_ptr<maze_t> hot_reload_t::take_maze() noexcept {
+    std::lock_guard<std::mutex> lock(mtx_pending);
+    std::unique_ptr<maze_t> res = std::move(pending_maze);
+    pending = pending_level_spec.size() > 0;
+    return res;
+}
+
+bool hot_reload_t::take_level_spec(std::vector<game_level_spec_t>& dest) noexcept {
+    std::lock_guard<std::mutex> lock(mtx_pending);
+    if( pending_level_spec.empty() ) {
+        return false;
+    }
+    dest = std::move(pending_level_spec);
+    pending_level_spec.clear();
+    pending = nullptr != pending_maze;
+    return true;
+}
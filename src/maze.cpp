@@ -26,8 +26,16 @@
 
 #include <iostream>
 #include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <deque>
+#include <queue>
 
 #include <strings.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 //
 // tile_t
@@ -503,40 +511,326 @@ std::string acoord_t::toIntString() const noexcept {
     return std::to_string(x_pos_i)+"/"+std::to_string(y_pos_i);
 }
 
+//
+// nav_graph_t
+//
+
+static int tile_step(const int x, const int y, const direction_t d, const int w, const int h) noexcept {
+    switch( d ) {
+        case direction_t::RIGHT: return y*w + ( x + 1 ) % w;
+        case direction_t::DOWN:  return ( ( y + 1 ) % h )*w + x;
+        case direction_t::LEFT:  return y*w + ( x + w - 1 ) % w;
+        case direction_t::UP:
+            [[fallthrough]];
+        default:                 return ( ( y + h - 1 ) % h )*w + x;
+    }
+}
+
+static int exit_count(const uint8_t exits) noexcept {
+    return __builtin_popcount( exits & 0x0f );
+}
+
+void nav_graph_t::build(const maze_t& maze) noexcept {
+    const int w = maze.width();
+    const int h = maze.height();
+    const direction_t dirs[] = { direction_t::RIGHT, direction_t::DOWN, direction_t::LEFT, direction_t::UP };
+    width_ = w;
+    nodes_.clear();
+    edges_.clear();
+    tile_node.assign( (size_t)w * (size_t)h, -1 );
+
+    // nodes: reachable intersections and dead ends
+    for(int y=0; y<h; ++y) {
+        for(int x=0; x<w; ++x) {
+            if( 0 <= maze.home_distance(x, y) && 2 != exit_count( maze.exits(x, y) ) ) {
+                tile_node[y*w+x] = (int)nodes_.size();
+                nodes_.push_back( { x, y, { -1, -1, -1, -1 } } );
+            }
+        }
+    }
+    // edges: walk each corridor leaving a node until the next node
+    for(size_t n=0; n<nodes_.size(); ++n) {
+        for(const direction_t d0 : dirs) {
+            if( !maze.can_exit(nodes_[n].x, nodes_[n].y, d0) ) {
+                continue;
+            }
+            int i = tile_step(nodes_[n].x, nodes_[n].y, d0, w, h);
+            direction_t d = d0;
+            int length = 1;
+            bool tunnel = maze.is_tunnel(nodes_[n].x, nodes_[n].y);
+            while( 0 > tile_node[i] && length <= w*h ) {
+                const int x = i % w, y = i / w;
+                tunnel = tunnel || maze.is_tunnel(x, y);
+                const direction_t back = inverse(d);
+                for(const direction_t nd : dirs) {
+                    if( nd != back && maze.can_exit(x, y, nd) ) {
+                        d = nd;
+                        break;
+                    }
+                }
+                i = tile_step(x, y, d, w, h);
+                ++length;
+            }
+            if( 0 > tile_node[i] ) {
+                continue; // closed loop w/o node
+            }
+            tunnel = tunnel || maze.is_tunnel(i % w, i / w);
+            nodes_[n].edge[number(d0)] = (int)edges_.size();
+            edges_.push_back( { (int)n, tile_node[i], d0, d, length, tunnel } );
+        }
+    }
+    // all pairs shortest paths, if small enough
+    const size_t nc = nodes_.size();
+    if( max_apsp_nodes < nc ) {
+        dist.clear();
+        return;
+    }
+    dist.assign(nc * nc, -1);
+    for(size_t n=0; n<nc; ++n) {
+        dist[n*nc+n] = 0;
+    }
+    for(const edge_t& e : edges_) {
+        int& d = dist[e.from*nc+e.to];
+        if( 0 > d || e.length < d ) {
+            d = e.length;
+        }
+    }
+    for(size_t k=0; k<nc; ++k) {
+        for(size_t i=0; i<nc; ++i) {
+            const int ik = dist[i*nc+k];
+            if( 0 > ik ) {
+                continue;
+            }
+            for(size_t j=0; j<nc; ++j) {
+                const int kj = dist[k*nc+j];
+                int& ij = dist[i*nc+j];
+                if( 0 <= kj && ( 0 > ij || ik + kj < ij ) ) {
+                    ij = ik + kj;
+                }
+            }
+        }
+    }
+}
+
+int nav_graph_t::distance(const int from, const int to) const noexcept {
+    if( 0 == dist.size() ) {
+        // Dijkstra
+        std::vector<int> d(nodes_.size(), -1);
+        std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> queue;
+        d[from] = 0;
+        queue.push( { 0, from } );
+        while( !queue.empty() ) {
+            const std::pair<int, int> top = queue.top();
+            queue.pop();
+            if( top.second == to ) {
+                return top.first;
+            }
+            if( top.first > d[top.second] ) {
+                continue;
+            }
+            for(const int e : nodes_[top.second].edge) {
+                if( 0 <= e ) {
+                    const edge_t& ed = edges_[e];
+                    if( 0 > d[ed.to] || top.first + ed.length < d[ed.to] ) {
+                        d[ed.to] = top.first + ed.length;
+                        queue.push( { d[ed.to], ed.to } );
+                    }
+                }
+            }
+        }
+        return -1;
+    }
+    return dist[from*nodes_.size()+to];
+}
+
+std::string nav_graph_t::toString() const noexcept {
+    int tunnels = 0;
+    for(const edge_t& e : edges_) {
+        tunnels += e.tunnel ? 1 : 0;
+    }
+    return "nav_graph[nodes "+std::to_string(nodes_.size())+", edges "+std::to_string(edges_.size())+
+           ", tunnel edges "+std::to_string(tunnels)+"]";
+}
+
+//
+// occupancy_grid_t
+//
+
+void occupancy_grid_t::reset(const int w, const int h, const int actor_count) noexcept {
+    width_ = std::max(0, w);
+    height_ = std::max(0, h);
+    head.assign( (size_t)width_ * (size_t)height_, -1 );
+    next.assign( std::max(0, actor_count), -1 );
+    tile.assign( std::max(0, actor_count), -1 );
+}
+
+void occupancy_grid_t::unlink(const int actor) noexcept {
+    const int t = tile[actor];
+    if( 0 > t ) {
+        return;
+    }
+    int* link = &head[t];
+    while( *link != actor ) {
+        link = &next[*link];
+    }
+    *link = next[actor];
+    next[actor] = -1;
+    tile[actor] = -1;
+}
+
+void occupancy_grid_t::update(const int actor, const int x, const int y) noexcept {
+    if( 0 > actor || actor >= actor_count() || 0 == width_ || 0 == height_ ) {
+        return;
+    }
+    const int t = std::max(0, std::min(height_-1, y)) * width_ + std::max(0, std::min(width_-1, x));
+    if( t == tile[actor] ) {
+        return;
+    }
+    unlink(actor);
+    next[actor] = head[t];
+    head[t] = actor;
+    tile[actor] = t;
+}
+
 //
 // maze_t::field_t
 //
 
 maze_t::field_t::field_t() noexcept
-: width_(0), height_(0)
+: width_(0), height_(0), tile_data(nullptr), words_per_row_(0)
 {
     bzero(&count_, sizeof(count_));
 }
 
+maze_t::field_t::field_t(const field_t& o) noexcept
+: width_(0), height_(0), tile_data(nullptr), words_per_row_(0)
+{
+    *this = o;
+}
+
+maze_t::field_t& maze_t::field_t::operator=(const field_t& o) noexcept {
+    if( this != &o ) {
+        width_ = o.width_;
+        height_ = o.height_;
+        if( nullptr != o.tile_data ) {
+            tiles.assign(o.tile_data, o.tile_data + (size_t)width_ * (size_t)height_);
+        } else {
+            tiles.clear();
+        }
+        tile_data = tiles.data();
+        memcpy(count_, o.count_, sizeof(count_));
+        words_per_row_ = o.words_per_row_;
+        rows = o.rows;
+        items = o.items;
+        item_pos = o.item_pos;
+        if( item_pos.size() != tiles.size() ) {
+            index_items(); // copy of a view
+        }
+    }
+    return *this;
+}
+
+void maze_t::field_t::index_items() noexcept {
+    items.clear();
+    items.reserve( (size_t)std::max(0, count_[number(tile_t::PELLET)] + count_[number(tile_t::PELLET_POWER)]) );
+    item_pos.assign(tiles.size(), -1);
+    for(size_t i=0; i<tiles.size(); ++i) {
+        if( is_item(tiles[i]) ) {
+            add_item( (int)i );
+        }
+    }
+}
+
+void maze_t::field_t::set_dim(const int w, const int h) noexcept {
+    width_=w; height_=h;
+    words_per_row_ = 0 < w && w <= max_dim ? ( w + 31 ) / 32 : 0;
+    rows.assign( (size_t)std::max(0, std::min(max_dim, h)) * layer_count * words_per_row_, 0 );
+}
+
 void maze_t::field_t::clear() noexcept {
-    width_ = 0; height_ = 0;
+    width_ = 0; height_ = 0; words_per_row_ = 0;
     tiles.clear();
+    tile_data = nullptr;
+    rows.clear();
+    items.clear();
+    item_pos.clear();
     bzero(&count_, sizeof(count_));
 }
 
 tile_t maze_t::field_t::tile(const int x, const int y) const noexcept {
     if( 0 <= x && x < width_ && 0 <= y && y < height_ ) {
-        return tiles[y*width_+x];
+        return tile_data[y*width_+x];
     }
     return tile_t::EMPTY;
 }
 
 void maze_t::field_t::add_tile(const tile_t tile) noexcept {
+    const size_t idx = tiles.size();
     tiles.push_back(tile);
+    tile_data = tiles.data();
+    item_pos.push_back(-1);
     ++count_[number(tile)];
+    if( is_item(tile) ) {
+        add_item( (int)idx );
+    }
+    if( 0 < words_per_row_ && height_ <= max_dim && idx < (size_t)width_ * (size_t)height_ ) {
+        set_bit( (int)( idx % width_ ), (int)( idx / width_ ), tile);
+    }
+}
+
+void maze_t::field_t::view(const int w, const int h, const tile_t* tiles_, const int32_t counts[]) noexcept {
+    set_dim(w, h);
+    tiles.clear();
+    tile_data = tiles_;
+    for(int i=0; i<tile_type_count; ++i) {
+        count_[i] = counts[i];
+    }
+    items.clear();
+    item_pos.clear();
+    if( w <= max_dim && h <= max_dim ) {
+        for(int y=0; y<h; ++y) {
+            for(int x=0; x<w; ++x) {
+                set_bit(x, y, tile_data[y*w+x]);
+            }
+        }
+    }
 }
 
 void maze_t::field_t::set_tile(const int x, const int y, tile_t tile) noexcept {
-    if( 0 <= x && x < width_ && 0 <= y && y < height_ ) {
-        const tile_t old_tile = tiles[y*width_+x];
-        tiles[y*width_+x] = tile;
+    if( 0 <= x && x < width_ && 0 <= y && y < height_ && !tiles.empty() ) { // not a read-only view
+        const int idx = y*width_+x;
+        const tile_t old_tile = tiles[idx];
+        tiles[idx] = tile;
         --count_[number(old_tile)];
         ++count_[number(tile)];
+        if( is_item(old_tile) != is_item(tile) ) {
+            if( is_item(tile) ) {
+                add_item(idx);
+            } else {
+                remove_item(idx);
+            }
+        }
+        clear_bit(x, y, old_tile);
+        set_bit(x, y, tile);
+    }
+}
+
+void maze_t::field_t::restore_consumables(const field_t& src, const int x, const int y) noexcept {
+    for(int yi=0; yi<height_; ++yi) {
+        for(const layer_t l : { layer_t::PELLET, layer_t::PELLET_POWER }) {
+            for(int wi=0; wi<words_per_row_; ++wi) {
+                uint32_t missing = src.row_word(l, yi, wi) & ~row_word(l, yi, wi);
+                while( 0 != missing ) {
+                    const int xi = wi*32 + __builtin_ctz(missing);
+                    set_tile(xi, yi, src.tile_nc(xi, yi));
+                    missing &= missing - 1;
+                }
+            }
+        }
+    }
+    const tile_t t = src.tile(x, y);
+    if( t != tile(x, y) ) {
+        set_tile(x, y, t);
     }
 }
 
@@ -591,108 +885,466 @@ bool maze_t::digest_ibox_line(const std::string& name, box_t& dest, const std::s
 }
 
 maze_t::maze_t(const std::string& fname) noexcept
-: filename(fname)
+: filename(fname), modcount_(0),
+  exits_(nullptr), home_dist_(nullptr), map_addr(nullptr), map_size(0)
 {
+    const bool ok = is_compiled_file(fname) ? load_compiled(fname) : parse_text(fname);
+    if( ok ) {
+        reset();
+
+        // center below ghost_home_ext, 1 tile, centered horizontal
+        fruit_pos_.set_pos(ghost_home_ext.center_x()-0.5f,  (float)(ghost_home_ext.y()+ghost_home_ext.height()));
+
+        // below ghost_home_ext, centered, whole length, 1 tile height
+        message_box_.set( ghost_home_ext.x(), ghost_home_ext.y()+ghost_home_ext.height(), ghost_home_ext.width(), 1);
+
+        if( !is_compiled() ) {
+            compute_derived_tables();
+        }
+        nav_graph_.build(*this);
+        return; // OK
+    }
+    unmap();
+    original.clear();
+    active.clear();
+    pacman_start_pos_.set_pos(0, 0);
+    ghost_home_ext.set(0, 0, 0, 0);
+    ghost_home_int.set(0, 0, 0, 0);
+    ghost_start.set(0, 0, 0, 0);
+    ppt_x_ = 0;
+    ppt_y_ = 0;
+}
+
+maze_t::~maze_t() noexcept {
+    unmap();
+}
+
+void maze_t::unmap() noexcept {
+    if( nullptr != map_addr ) {
+        munmap(map_addr, map_size);
+        map_addr = nullptr;
+        map_size = 0;
+        exits_ = nullptr;
+        home_dist_ = nullptr;
+    }
+}
+
+bool maze_t::parse_text(const std::string& fname) noexcept {
     int field_line_iter = 0;
     std::fstream file;
     file.open(fname, std::ios::in);
-    if( file.is_open() ) {
-        std::string line;
-        while( std::getline(file, line) ) {
-            if( 0 == original.width() || 0 == original.height() ) {
-                int w=-1, h=-1;
-                int visual_width=-1, visual_height=-1;
-                sscanf(line.c_str(), "%d %d %d %d", &w, &h, &visual_width, &visual_height);
-                original.set_dim(w, h);
-                ppt_x_ = visual_width / original.width();
-                ppt_y_ = visual_height / original.height();
-                if( DEBUG ) {
-                    log_printf("maze: read dimension: %s\n", toString().c_str());
-                }
-            } else if( digest_iposition_line("top_left_scatter", top_left_scatter_, line) ) {
-            } else if( digest_iposition_line("bottom_left_scatter", bottom_left_scatter_, line) ) {
-            } else if( digest_iposition_line("bottom_right_scatter", bottom_right_scatter_, line) ) {
-            } else if( digest_iposition_line("top_right_scatter", top_right_scatter_, line) ) {
-            } else if( digest_ibox_line("tunnel1", tunnel1, line) ) {
-            } else if( digest_ibox_line("tunnel2", tunnel2, line) ) {
-            } else if( digest_ibox_line("red_zone1", red_zone1, line) ) {
-            } else if( digest_ibox_line("red_zone2", red_zone2, line) ) {
-            } else if( digest_fposition_line("pacman", pacman_start_pos_, line) ) {
-            } else if( digest_ibox_line("ghost_home_ext", ghost_home_ext, line) ) {
-            } else if( digest_ibox_line("ghost_home_int", ghost_home_int, line) ) {
-            } else if( digest_ibox_line("ghost_start", ghost_start, line) ) {
-            } else if( 0 == texture_file.length() ) {
-                texture_file = line;
-            } else if( field_line_iter < original.height() ) {
-                if( DEBUG ) {
-                    log_printf("maze: read line y = %d, len = %zd: %s\n", field_line_iter, line.length(), line.c_str());
-                }
-                if( line.length() == (size_t)original.width() ) {
-                    for(int x=0; x<original.width(); ++x) {
-                        const char c = line[x];
-                        switch( c ) {
-                            case '_':
-                                original.add_tile(tile_t::EMPTY);
-                                break;
-                            case '|':
-                                original.add_tile(tile_t::WALL);
-                                break;
-                            case '-':
-                                original.add_tile(tile_t::GATE);
-                                break;
-                            case '.':
-                                original.add_tile(tile_t::PELLET);
-                                break;
-                            case '*':
-                                original.add_tile(tile_t::PELLET_POWER);
-                                break;
-                            default:
-                                log_printf("maze error: unknown tile @ %d / %d: '%c'\n", x, field_line_iter, c);
-                                break;
-                        }
+    if( !file.is_open() ) {
+        log_printf("Could not open maze file: %s\n", filename.c_str());
+        return false;
+    }
+    std::string line;
+    while( std::getline(file, line) ) {
+        if( 0 == original.width() || 0 == original.height() ) {
+            int w=-1, h=-1;
+            int visual_width=-1, visual_height=-1;
+            sscanf(line.c_str(), "%d %d %d %d", &w, &h, &visual_width, &visual_height);
+            original.set_dim(w, h);
+            ppt_x_ = visual_width / original.width();
+            ppt_y_ = visual_height / original.height();
+            if( DEBUG ) {
+                log_printf("maze: read dimension: %s\n", toString().c_str());
+            }
+        } else if( digest_iposition_line("top_left_scatter", top_left_scatter_, line) ) {
+        } else if( digest_iposition_line("bottom_left_scatter", bottom_left_scatter_, line) ) {
+        } else if( digest_iposition_line("bottom_right_scatter", bottom_right_scatter_, line) ) {
+        } else if( digest_iposition_line("top_right_scatter", top_right_scatter_, line) ) {
+        } else if( digest_ibox_line("tunnel1", tunnel1, line) ) {
+        } else if( digest_ibox_line("tunnel2", tunnel2, line) ) {
+        } else if( digest_ibox_line("red_zone1", red_zone1, line) ) {
+        } else if( digest_ibox_line("red_zone2", red_zone2, line) ) {
+        } else if( digest_fposition_line("pacman", pacman_start_pos_, line) ) {
+        } else if( digest_ibox_line("ghost_home_ext", ghost_home_ext, line) ) {
+        } else if( digest_ibox_line("ghost_home_int", ghost_home_int, line) ) {
+        } else if( digest_ibox_line("ghost_start", ghost_start, line) ) {
+        } else if( 0 == texture_file.length() ) {
+            texture_file = line;
+        } else if( field_line_iter < original.height() ) {
+            if( DEBUG ) {
+                log_printf("maze: read line y = %d, len = %zd: %s\n", field_line_iter, line.length(), line.c_str());
+            }
+            if( line.length() == (size_t)original.width() ) {
+                for(int x=0; x<original.width(); ++x) {
+                    const char c = line[x];
+                    switch( c ) {
+                        case '_':
+                            original.add_tile(tile_t::EMPTY);
+                            break;
+                        case '|':
+                            original.add_tile(tile_t::WALL);
+                            break;
+                        case '-':
+                            original.add_tile(tile_t::GATE);
+                            break;
+                        case '.':
+                            original.add_tile(tile_t::PELLET);
+                            break;
+                        case '*':
+                            original.add_tile(tile_t::PELLET_POWER);
+                            break;
+                        default:
+                            log_printf("maze error: unknown tile @ %d / %d: '%c'\n", x, field_line_iter, c);
+                            break;
                     }
                 }
-                ++field_line_iter;
             }
+            ++field_line_iter;
         }
-        file.close();
-        if( original.validate_size() ) {
-            reset();
+    }
+    file.close();
+    return original.validate_size();
+}
+
+/** 32-bit FNV-1a */
+static uint32_t hash_bytes(const uint8_t* data, const size_t count, uint32_t h = 0x811c9dc5U) noexcept {
+    for(size_t i=0; i<count; ++i) {
+        h = ( h ^ data[i] ) * 0x01000193U;
+    }
+    return h;
+}
 
-            // center below ghost_home_ext, 1 tile, centered horizontal
-            fruit_pos_.set_pos(ghost_home_ext.center_x()-0.5f,  (float)(ghost_home_ext.y()+ghost_home_ext.height()));
+static constexpr size_t align4(const size_t v) noexcept { return ( v + 3 ) & ~(size_t)3; }
 
-            // below ghost_home_ext, centered, whole length, 1 tile height
-            message_box_.set( ghost_home_ext.x(), ghost_home_ext.y()+ghost_home_ext.height(), ghost_home_ext.width(), 1);
+bool maze_t::is_compiled_file(const std::string& fname) noexcept {
+    char magic[sizeof(maze_bin_header_t::magic_value)];
+    FILE* in = fopen(fname.c_str(), "rb");
+    if( nullptr == in ) {
+        return false;
+    }
+    const bool res = 1 == fread(magic, sizeof(magic), 1, in) &&
+                     0 == memcmp(magic, maze_bin_header_t::magic_value, sizeof(magic));
+    fclose(in);
+    return res;
+}
 
-            return; // OK
+/**
+ * Returns true if the header's scatter targets, boxes and pacman start position lie within the maze dimension,
+ * as they are not covered by the checksum over the tables.
+ */
+static bool header_positions_valid(const maze_bin_header_t& h) noexcept {
+    for(int i=0; i<4; ++i) {
+        if( 0 > h.scatter[i][0] || h.width <= h.scatter[i][0] || 0 > h.scatter[i][1] || h.height <= h.scatter[i][1] ) {
+            return false;
+        }
+    }
+    for(int i=0; i<maze_bin_header_t::box_count; ++i) {
+        const int32_t* b = h.boxes[i];
+        if( 0 > b[0] || 0 > b[1] || 0 > b[2] || 0 > b[3] || h.width - b[0] < b[2] || h.height - b[1] < b[3] ) {
+            return false;
         }
+    }
+    return 0 <= h.pacman_start[0] && h.pacman_start[0] < (float)h.width &&
+           0 <= h.pacman_start[1] && h.pacman_start[1] < (float)h.height;
+}
+
+bool maze_t::load_compiled(const std::string& fname) noexcept {
+    const int fd = ::open(fname.c_str(), O_RDONLY);
+    if( 0 > fd ) {
+        log_printf("Could not open maze file: %s\n", fname.c_str());
+        return false;
+    }
+    struct stat st;
+    if( 0 != fstat(fd, &st) || (size_t)st.st_size < sizeof(maze_bin_header_t) ) {
+        log_printf("maze error: %s: truncated header\n", fname.c_str());
+        ::close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if( MAP_FAILED == addr ) {
+        log_printf("maze error: %s: mmap failed: %s\n", fname.c_str(), strerror(errno));
+        return false;
+    }
+    map_addr = addr;
+    map_size = (size_t)st.st_size;
+
+    const uint8_t* base = static_cast<const uint8_t*>(addr);
+    const maze_bin_header_t& h = *static_cast<const maze_bin_header_t*>(addr);
+    const size_t n = (size_t)std::max(0, h.width) * (size_t)std::max(0, h.height);
+    const char* err = nullptr;
+    if( 0 != memcmp(h.magic, maze_bin_header_t::magic_value, sizeof(h.magic)) ) {
+        err = "invalid magic";
+    } else if( maze_bin_header_t::version_value != h.version ) {
+        err = "unsupported version";
+    } else if( maze_bin_header_t::byte_order_value != h.byte_order ) {
+        err = "byte order mismatch";
+    } else if( sizeof(maze_bin_header_t) != h.header_size || map_size != h.file_size ) {
+        err = "size mismatch";
+    } else if( 0 >= h.width || 0 >= h.height || field_t::max_dim < h.width || field_t::max_dim < h.height || 0 >= h.ppt_x || 0 >= h.ppt_y ) {
+        err = "invalid dimension";
+    } else if( '\0' != h.texture_file[sizeof(h.texture_file)-1] ) {
+        err = "invalid texture file";
+    } else if( h.tiles_offset < h.header_size || 0 != h.tiles_offset % alignof(int32_t) ||
+               h.exits_offset < h.tiles_offset + n*sizeof(int32_t) ||
+               h.home_dist_offset < h.exits_offset + n || 0 != h.home_dist_offset % alignof(uint16_t) ||
+               map_size < h.home_dist_offset + n*sizeof(uint16_t) ) {
+        err = "invalid table offsets";
+    } else if( hash_bytes(base + h.header_size, map_size - h.header_size) != h.checksum ) {
+        err = "checksum mismatch";
+    } else if( !header_positions_valid(h) ) {
+        err = "invalid position";
     } else {
-        log_printf("Could not open maze file: %s\n", filename.c_str());
+        const int32_t* tiles = reinterpret_cast<const int32_t*>(base + h.tiles_offset);
+        int32_t counts[tile_type_count] = { 0 };
+        for(size_t i=0; i<n && nullptr == err; ++i) {
+            if( 0 > tiles[i] || number(tile_t::KEY) < tiles[i] ) {
+                err = "invalid tile";
+            } else {
+                ++counts[tiles[i]];
+            }
+        }
+        if( nullptr == err && 0 != memcmp(counts, h.count, sizeof(counts)) ) {
+            err = "tile count mismatch";
+        }
     }
-    original.clear();
-    pacman_start_pos_.set_pos(0, 0);
-    ghost_home_ext.set(0, 0, 0, 0);
-    ghost_home_int.set(0, 0, 0, 0);
-    ghost_start.set(0, 0, 0, 0);
-    ppt_x_ = 0;
-    ppt_y_ = 0;
+    if( nullptr != err ) {
+        log_printf("maze error: %s: %s\n", fname.c_str(), err);
+        return false;
+    }
+    top_left_scatter_.set_pos(h.scatter[0][0], h.scatter[0][1]);
+    bottom_left_scatter_.set_pos(h.scatter[1][0], h.scatter[1][1]);
+    bottom_right_scatter_.set_pos(h.scatter[2][0], h.scatter[2][1]);
+    top_right_scatter_.set_pos(h.scatter[3][0], h.scatter[3][1]);
+    box_t* boxes[] = { &tunnel1, &tunnel2, &red_zone1, &red_zone2, &ghost_home_ext, &ghost_home_int, &ghost_start };
+    for(int i=0; i<maze_bin_header_t::box_count; ++i) {
+        boxes[i]->set(h.boxes[i][0], h.boxes[i][1], h.boxes[i][2], h.boxes[i][3]);
+    }
+    pacman_start_pos_.set_pos(h.pacman_start[0], h.pacman_start[1]);
+    ppt_x_ = h.ppt_x;
+    ppt_y_ = h.ppt_y;
+    texture_file = h.texture_file;
+    static_assert( sizeof(tile_t) == sizeof(int32_t), "tile_t must be int32_t sized" );
+    // zero-copy, the active tiles are copied from the mapped ones at the first level start, see reset()
+    original.view(h.width, h.height, reinterpret_cast<const tile_t*>(base + h.tiles_offset), h.count);
+    exits_ = base + h.exits_offset;
+    home_dist_ = reinterpret_cast<const uint16_t*>(base + h.home_dist_offset);
+    if( DEBUG ) {
+        log_printf("maze: mapped %zu bytes: %s\n", map_size, toString().c_str());
+    }
+    return true;
 }
 
-void maze_t::draw(std::function<void(const float x, const float y, tile_t tile)> draw_pixel) noexcept {
-    for(int y=0; y<height(); ++y) {
-        for(int x=0; x<width(); ++x) {
-            if( fruit_pos_.intersects_i(x, y) ) {
-                draw_pixel(fruit_pos_.x_f(), fruit_pos_.y_f(), active.tile_nc(x, y));
+void maze_t::compute_derived_tables() noexcept {
+    const int w = original.width();
+    const int h = original.height();
+    const size_t n = (size_t)w * (size_t)h;
+    derived_tables.assign(align4(n) + n*sizeof(uint16_t), 0);
+    uint8_t* exits = derived_tables.data();
+    uint16_t* home_dist = reinterpret_cast<uint16_t*>(derived_tables.data() + align4(n));
+
+    auto walkable = [&](const int x, const int y) -> bool {
+        const uint32_t blocked = original.row_word(layer_t::WALL, y, x >> 5) | original.row_word(layer_t::GATE, y, x >> 5);
+        return 0 == ( blocked & ( 1U << ( x & 31 ) ) );
+    };
+    auto neighbor = [&](const int x, const int y, const direction_t d, int& nx, int& ny) {
+        nx = x; ny = y;
+        switch( d ) {
+            case direction_t::RIGHT: nx = ( x + 1 ) % w; break;
+            case direction_t::DOWN:  ny = ( y + 1 ) % h; break;
+            case direction_t::LEFT:  nx = ( x + w - 1 ) % w; break;
+            case direction_t::UP:
+                [[fallthrough]];
+            default:                 ny = ( y + h - 1 ) % h; break;
+        }
+    };
+    const direction_t dirs[] = { direction_t::RIGHT, direction_t::DOWN, direction_t::LEFT, direction_t::UP };
+    std::deque<int> queue;
+    for(int y=0; y<h; ++y) {
+        for(int x=0; x<w; ++x) {
+            uint8_t e = 0;
+            for(const direction_t d : dirs) {
+                int nx, ny;
+                neighbor(x, y, d, nx, ny);
+                if( walkable(nx, ny) ) {
+                    e |= 1 << number(d);
+                }
+            }
+            const acoord_t p(x, y);
+            if( p.intersects_i(tunnel1) || p.intersects_i(tunnel2) ) {
+                e |= TILE_TUNNEL;
+            }
+            if( p.intersects_i(red_zone1) || p.intersects_i(red_zone2) ) {
+                e |= TILE_RED_ZONE;
+            }
+            exits[y*w+x] = e;
+            if( p.intersects_i(ghost_start) && walkable(x, y) ) {
+                home_dist[y*w+x] = 0;
+                queue.push_back(y*w+x);
             } else {
-                draw_pixel(x, y, active.tile_nc(x, y));
+                home_dist[y*w+x] = 0xffff;
+            }
+        }
+    }
+    // breadth first walk from ghost_start
+    while( !queue.empty() ) {
+        const int i = queue.front();
+        queue.pop_front();
+        for(const direction_t d : dirs) {
+            if( 0 != ( exits[i] & ( 1 << number(d) ) ) ) {
+                int nx, ny;
+                neighbor(i % w, i / w, d, nx, ny);
+                if( 0xffff == home_dist[ny*w+nx] ) {
+                    home_dist[ny*w+nx] = std::min(0xfffe, home_dist[i] + 1);
+                    queue.push_back(ny*w+nx);
+                }
+            }
+        }
+    }
+    exits_ = exits;
+    home_dist_ = home_dist;
+}
+
+bool maze_t::write_compiled(const std::string& fname) const noexcept {
+    if( !is_ok() || texture_file.size() >= sizeof(maze_bin_header_t::texture_file) ) {
+        log_printf("maze error: %s: cannot compile %s\n", fname.c_str(), toString().c_str());
+        return false;
+    }
+    const int w = original.width();
+    const int h = original.height();
+    const size_t n = (size_t)w * (size_t)h;
+
+    maze_bin_header_t hdr;
+    bzero(&hdr, sizeof(hdr));
+    memcpy(hdr.magic, maze_bin_header_t::magic_value, sizeof(hdr.magic));
+    hdr.version = maze_bin_header_t::version_value;
+    hdr.byte_order = maze_bin_header_t::byte_order_value;
+    hdr.header_size = sizeof(hdr);
+    hdr.width = w;
+    hdr.height = h;
+    hdr.ppt_x = ppt_x_;
+    hdr.ppt_y = ppt_y_;
+    const acoord_t* scatter[] = { &top_left_scatter_, &bottom_left_scatter_, &bottom_right_scatter_, &top_right_scatter_ };
+    for(int i=0; i<4; ++i) {
+        hdr.scatter[i][0] = scatter[i]->x_i();
+        hdr.scatter[i][1] = scatter[i]->y_i();
+    }
+    const box_t* boxes[] = { &tunnel1, &tunnel2, &red_zone1, &red_zone2, &ghost_home_ext, &ghost_home_int, &ghost_start };
+    for(int i=0; i<maze_bin_header_t::box_count; ++i) {
+        hdr.boxes[i][0] = boxes[i]->x();
+        hdr.boxes[i][1] = boxes[i]->y();
+        hdr.boxes[i][2] = boxes[i]->width();
+        hdr.boxes[i][3] = boxes[i]->height();
+    }
+    hdr.pacman_start[0] = pacman_start_pos_.x_f();
+    hdr.pacman_start[1] = pacman_start_pos_.y_f();
+    for(int i=0; i<tile_type_count; ++i) {
+        hdr.count[i] = original.count( static_cast<tile_t>(i) );
+    }
+    memcpy(hdr.texture_file, texture_file.c_str(), texture_file.size());
+    hdr.tiles_offset = align4(sizeof(hdr));
+    hdr.exits_offset = hdr.tiles_offset + n*sizeof(int32_t);
+    hdr.home_dist_offset = align4(hdr.exits_offset + n);
+    hdr.file_size = hdr.home_dist_offset + n*sizeof(uint16_t);
+
+    std::vector<uint8_t> data(hdr.file_size, 0);
+    int32_t* tiles = reinterpret_cast<int32_t*>(data.data() + hdr.tiles_offset);
+    for(int y=0; y<h; ++y) {
+        for(int x=0; x<w; ++x) {
+            tiles[y*w+x] = number( original.tile_nc(x, y) );
+        }
+    }
+    memcpy(data.data() + hdr.exits_offset, exits_, n);
+    memcpy(data.data() + hdr.home_dist_offset, home_dist_, n*sizeof(uint16_t));
+    hdr.checksum = hash_bytes(data.data() + hdr.header_size, hdr.file_size - hdr.header_size);
+    memcpy(data.data(), &hdr, sizeof(hdr));
+
+    // write a temporary file and rename it over the target, never leaving a partially written maze behind
+    const std::string tmp_fname = fname + ".tmp";
+    FILE* out = fopen(tmp_fname.c_str(), "wb");
+    if( nullptr == out ) {
+        log_printf("maze error: %s: could not create: %s\n", tmp_fname.c_str(), strerror(errno));
+        return false;
+    }
+    const bool res = 1 == fwrite(data.data(), data.size(), 1, out) && 0 == fflush(out) && 0 == fsync(fileno(out));
+    if( 0 != fclose(out) || !res ) {
+        log_printf("maze error: %s: write failed: %s\n", tmp_fname.c_str(), strerror(errno));
+        unlink(tmp_fname.c_str());
+        return false;
+    }
+    if( 0 != rename(tmp_fname.c_str(), fname.c_str()) ) {
+        log_printf("maze error: %s: rename failed: %s\n", fname.c_str(), strerror(errno));
+        unlink(tmp_fname.c_str());
+        return false;
+    }
+    return true;
+}
+
+uint32_t maze_t::checksum() const noexcept {
+    std::vector<int32_t> data;
+    data.reserve(4 + 8 + 7*4 + 2 + (size_t)original.width()*(size_t)original.height());
+    data.push_back(original.width());
+    data.push_back(original.height());
+    data.push_back(ppt_x_);
+    data.push_back(ppt_y_);
+    for(const acoord_t* p : { &top_left_scatter_, &bottom_left_scatter_, &bottom_right_scatter_, &top_right_scatter_ }) {
+        data.push_back(p->x_i());
+        data.push_back(p->y_i());
+    }
+    for(const box_t* b : { &tunnel1, &tunnel2, &red_zone1, &red_zone2, &ghost_home_ext, &ghost_home_int, &ghost_start }) {
+        data.push_back(b->x());
+        data.push_back(b->y());
+        data.push_back(b->width());
+        data.push_back(b->height());
+    }
+    for(const float v : { pacman_start_pos_.x_f(), pacman_start_pos_.y_f() }) {
+        int32_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        data.push_back(bits);
+    }
+    original.for_each_tile([&data](const int x, const int y, const tile_t tile) {
+        data.push_back( number(tile) );
+        (void)x; (void)y;
+    });
+    return hash_bytes(reinterpret_cast<const uint8_t*>(data.data()), data.size()*sizeof(int32_t));
+}
+
+int maze_t::count(const layer_t layer, const box_t& region) const noexcept {
+    const int x0 = std::max(0, region.x());
+    const int x1 = std::min(width(), region.x() + region.width());
+    if( x0 >= x1 ) {
+        return 0;
+    }
+    const int w0 = x0 >> 5, w1 = ( x1 - 1 ) >> 5;
+    const int y1 = std::min(height(), region.y() + region.height());
+    int res = 0;
+    for(int y=std::max(0, region.y()); y<y1; ++y) {
+        for(int wi=w0; wi<=w1; ++wi) {
+            uint32_t mask = ~0U;
+            if( wi == w0 ) {
+                mask &= ~0U << ( x0 & 31 );
+            }
+            if( wi == w1 && 0 != ( x1 & 31 ) ) {
+                mask &= ~( ~0U << ( x1 & 31 ) );
+            }
+            res += __builtin_popcount( active.row_word(layer, y, wi) & mask );
+        }
+    }
+    return res;
+}
+
+void maze_t::copy_bitboards(std::vector<uint32_t>& dest) const noexcept {
+    const int wpr = words_per_row();
+    dest.resize( (size_t)height() * layer_count * wpr );
+    for(int y=0; y<height(); ++y) {
+        for(int l=0; l<layer_count; ++l) {
+            for(int wi=0; wi<wpr; ++wi) {
+                dest[(size_t)( y*layer_count+l )*wpr+wi] = active.row_word(static_cast<layer_t>(l), y, wi);
             }
         }
     }
 }
 
 void maze_t::reset() noexcept {
-    active = original;
+    if( active.width() != original.width() || active.height() != original.height() ) {
+        active = original; // initial
+    } else {
+        active.restore_consumables(original, fruit_pos_.x_i(), fruit_pos_.y_i());
+    }
+    ++modcount_;
 }
 
 std::string maze_t::toString() const noexcept {
@@ -705,6 +1357,8 @@ std::string maze_t::toString() const noexcept {
                     ", pellets[ normal "+std::to_string(count(tile_t::PELLET))+"/"+std::to_string(max(tile_t::PELLET))+
                     ", power "+std::to_string(count(tile_t::PELLET_POWER))+"/"+std::to_string(max(tile_t::PELLET_POWER))+
                     "], tex "+texture_file+
+                    ", "+( is_compiled() ? "mapped "+std::to_string(map_size)+" bytes" : "text" )+
                     ", ppt "+std::to_string(ppt_x_)+"x"+std::to_string(ppt_y_)+
+                    ", "+nav_graph_.toString()+
                     "]";
 }
@@ -0,0 +1,114 @@
+/*
+ * Author: Sven Gothel <sgothel@jausoft.com> and Svenson Han Gothel
+ * Copyright (c) 2022 Gothel Software e.K.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <pacman/globals.hpp>
+
+// maze_t's acoord_t requires the following game globals
+std::unique_ptr<maze_t> global_maze;
+bool use_original_pacman_behavior() noexcept { return true; }
+
+static constexpr tile_t layer_tile(const layer_t l) noexcept {
+    switch( l ) {
+        case layer_t::WALL: return tile_t::WALL;
+        case layer_t::GATE: return tile_t::GATE;
+        case layer_t::PELLET: return tile_t::PELLET;
+        default: return tile_t::PELLET_POWER;
+    }
+}
+
+/**
+ * Returns true if the bitboards of both mazes are identical
+ * and their queries match the tiles of the given source maze,
+ * i.e. test() per tile as well as count() of its boxes and quadrants.
+ */
+static bool verify_bitboards(const maze_t& src, const maze_t& compiled) noexcept {
+    std::vector<uint32_t> bb_src, bb_compiled;
+    src.copy_bitboards(bb_src);
+    compiled.copy_bitboards(bb_compiled);
+    if( bb_src != bb_compiled || bb_src.size() != (size_t)src.height() * maze_t::layer_count * src.words_per_row() ) {
+        log_printf("Maze: Error: bitboard export mismatch\n");
+        return false;
+    }
+    const int w = src.width(), h = src.height();
+    const box_t regions[] = { box_t(0, 0, w, h), box_t(0, 0, w/2, h/2), box_t(w/2, 0, w-w/2, h/2),
+                              box_t(0, h/2, w/2, h-h/2), box_t(w/2, h/2, w-w/2, h-h/2),
+                              src.tunnel1_box(), src.tunnel2_box(), src.red_zone1_box(), src.red_zone2_box(),
+                              src.ghost_home_ext_box(), src.ghost_home_int_box(), src.ghost_start_box() };
+    for(const layer_t l : { layer_t::WALL, layer_t::GATE, layer_t::PELLET, layer_t::PELLET_POWER }) {
+        const tile_t t = layer_tile(l);
+        for(int y=0; y<h; ++y) {
+            for(int x=0; x<w; ++x) {
+                if( compiled.test(l, x, y) != ( t == src.tile(x, y) ) ) {
+                    log_printf("Maze: Error: bitboard %s mismatch at %d/%d\n", to_string(t).c_str(), x, y);
+                    return false;
+                }
+            }
+        }
+        for(const box_t& r : regions) {
+            int expected = 0;
+            for(int y=std::max(0, r.y()); y<std::min(h, r.y()+r.height()); ++y) {
+                for(int x=std::max(0, r.x()); x<std::min(w, r.x()+r.width()); ++x) {
+                    expected += t == src.tile(x, y) ? 1 : 0;
+                }
+            }
+            if( compiled.count(l, r) != expected ) {
+                log_printf("Maze: Error: bitboard %s count %d != %d within %s\n", to_string(t).c_str(), compiled.count(l, r), expected, r.toString().c_str());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Compiles a text maze file, e.g. `media/playfield_pacman.txt`,
+ * into a binary maze file including its derived tables, loaded via `pacman -maze <file>` without parsing.
+ *
+ * The result is validated by mapping it, comparing its bitboards and their queries against the source tiles.
+ */
+int main(int argc, char *argv[])
+{
+    if( 3 > argc ) {
+        fprintf(stderr, "Usage: %s <maze-text-file> <maze-binary-file>\n", argv[0]);
+        return 1;
+    }
+    global_maze = std::make_unique<maze_t>(argv[1]);
+    if( !global_maze->is_ok() ) {
+        log_printf("Maze: Error: %s\n", global_maze->toString().c_str());
+        return 1;
+    }
+    if( !global_maze->write_compiled(argv[2]) ) {
+        return 1;
+    }
+    // validate the result by mapping it
+    maze_t compiled(argv[2]);
+    if( !compiled.is_ok() || !compiled.is_compiled() ) {
+        log_printf("Maze: Error: %s\n", compiled.toString().c_str());
+        return 1;
+    }
+    if( !verify_bitboards(*global_maze, compiled) ) {
+        return 1;
+    }
+    log_printf("Maze: %s\n", compiled.toString().c_str());
+    return 0;
+}
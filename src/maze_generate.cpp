@@ -0,0 +1,221 @@
+/*
+ * Author: Sven Gothel <sgothel@jausoft.com> and Svenson Han Gothel
+ * Copyright (c) 2022 Gothel Software e.K.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <pacman/globals.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+
+// maze_t's acoord_t requires the following game globals
+std::unique_ptr<maze_t> global_maze;
+bool use_original_pacman_behavior() noexcept { return true; }
+
+/** Lattice spacing of corridors, leaving two tiles thick walls in between */
+static constexpr const int spacing = 3;
+
+struct segment_t {
+    int a, b;
+    bool used;
+};
+
+static int find_set(std::vector<int>& parent, int i) noexcept {
+    while( parent[i] != i ) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+/**
+ * Generates a text maze file of given dimension, see maze_t.
+ *
+ * Corridors are laid out on a lattice with two tiles thick walls,
+ * connected by a random spanning tree plus random loops without dead ends.
+ * The ghost house is centered, surrounded by a corridor ring,
+ * the tunnel passes its side and pacman starts below.
+ */
+static bool generate(const std::string& fname, const int w, const int h, const unsigned int seed) noexcept {
+    random_engine_t<random_engine_mode_t::STD_PRNG_0> rng;
+    rng.seed(seed);
+
+    // lattice nodes within the walled frame rows [3 .. h-3], leaving the top and bottom lines to the score and status
+    std::vector<int> cols, rows;
+    for(int x=1; x<=w-2; x+=spacing) { cols.push_back(x); }
+    for(int y=4; y<=h-4; y+=spacing) { rows.push_back(y); }
+    const int nc = (int)cols.size(), nr = (int)rows.size();
+
+    std::vector<segment_t> segments;
+    for(int r=0; r<nr; ++r) {
+        for(int c=0; c<nc; ++c) {
+            if( c+1 < nc ) { segments.push_back( { r*nc+c, r*nc+c+1, false } ); }
+            if( r+1 < nr ) { segments.push_back( { r*nc+c, (r+1)*nc+c, false } ); }
+        }
+    }
+    std::shuffle(segments.begin(), segments.end(), rng);
+
+    // random spanning tree (Kruskal), then remove dead ends and add random loops
+    std::vector<int> parent(nc*nr);
+    std::iota(parent.begin(), parent.end(), 0);
+    std::vector<int> degree(nc*nr, 0);
+    for(segment_t& s : segments) {
+        const int pa = find_set(parent, s.a), pb = find_set(parent, s.b);
+        if( pa != pb ) {
+            parent[pa] = pb;
+            s.used = true;
+            ++degree[s.a]; ++degree[s.b];
+        }
+    }
+    for(segment_t& s : segments) {
+        if( !s.used && ( 1 == degree[s.a] || 1 == degree[s.b] || 0 == rng() % 4 ) ) {
+            s.used = true;
+            ++degree[s.a]; ++degree[s.b];
+        }
+    }
+
+    std::vector<char> field((size_t)w * (size_t)h, '|');
+    auto at = [&](const int x, const int y) -> char& { return field[(size_t)y*w+x]; };
+    auto fill = [&](const int x0, const int y0, const int bw, const int bh, const char c) {
+        for(int y=y0; y<y0+bh; ++y) {
+            for(int x=x0; x<x0+bw; ++x) {
+                at(x, y) = c;
+            }
+        }
+    };
+    fill(0, 0, w, 3, '_');
+    fill(0, h-2, w, 2, '_');
+    for(const segment_t& s : segments) {
+        if( s.used ) {
+            const int x0 = cols[s.a % nc], y0 = rows[s.a / nc];
+            const int x1 = cols[s.b % nc], y1 = rows[s.b / nc];
+            fill(x0, y0, x1-x0+1, y1-y0+1, '.');
+        }
+    }
+
+    // ghost house incl. gate, surrounded by an empty corridor ring
+    const int hx = w/2 - 4, hy = h/2 - 3;
+    fill(hx-1, hy-1, 10, 7, '_');
+    fill(hx, hy, 8, 5, '|');
+    fill(hx+1, hy+1, 6, 3, '_');
+    fill(hx+3, hy, 2, 1, '-');
+
+    // tunnel row passing the ghost house
+    int ty = rows[0];
+    for(const int y : rows) {
+        if( std::abs(y - (hy+2)) < std::abs(ty - (hy+2)) ) { ty = y; }
+    }
+    fill(0, ty, 5, 1, '_');
+    fill(w-5, ty, 5, 1, '_');
+    if( cols.back() < w-5 ) {
+        fill(cols.back(), ty, w-5-cols.back(), 1, '.');
+    }
+
+    // pacman starts on the lattice node below the ring, closest to the center
+    int py = rows.back(), px = cols[0];
+    for(const int y : rows) {
+        if( y > hy+5 && y < py ) { py = y; }
+    }
+    for(const int x : cols) {
+        if( std::abs(x - w/2) < std::abs(px - w/2) ) { px = x; }
+    }
+    at(px, py) = '_';
+
+    // power pellets at the outer lattice nodes of the 2nd top and bottom rows
+    for(const int y : { rows[1], rows[nr-2] }) {
+        at(cols[0], y) = '*';
+        at(cols[nc-1], y) = '*';
+    }
+
+    FILE* out = fopen(fname.c_str(), "w");
+    if( nullptr == out ) {
+        log_printf("Error creating %s: %s\n", fname.c_str(), strerror(errno));
+        return false;
+    }
+    fprintf(out, "%4d %4d %5d %5d // dimension tile and visual, generated with seed %u\n", w, h, w*8, h*8, seed);
+    fprintf(out, "%4d %4d           // top-left scatter target\n", 2, 0);
+    fprintf(out, "%4d %4d           // bottom-left scatter target\n", 0, h-1);
+    fprintf(out, "%4d %4d           // bottom-right scatter target\n", w-1, h-1);
+    fprintf(out, "%4d %4d           // top-right scatter target\n", w-3, 0);
+    fprintf(out, "%4d %4d %4d %4d // tunnel-1 [x, y, width, height]\n", 0, ty, 5, 1);
+    fprintf(out, "%4d %4d %4d %4d // tunnel-2 [x, y, width, height]\n", w-5, ty, 5, 1);
+    fprintf(out, "%4d %4d %4d %4d // red-zone-1 [x, y, width, height]\n", hx+1, hy-1, 6, 1);
+    fprintf(out, "%4d %4d %4d %4d // red-zone-2 [x, y, width, height]\n", px-3, py, 6, 1);
+    fprintf(out, "%4d.0 %4d.0       // pacman start position\n", px, py);
+    fprintf(out, "%4d %4d %4d %4d // ghost home exterior incl. walls and gate [x, y, width, height]\n", hx, hy, 8, 5);
+    fprintf(out, "%4d %4d %4d %4d // ghost home interior excl. walls and gate [x, y, width, height]\n", hx+1, hy+1, 6, 3);
+    fprintf(out, "%4d %4d %4d %4d // ghost start box [x, y, widht, height]\n", hx+3, hy-1, 2, 1);
+    fprintf(out, "-\n");
+    for(int y=0; y<h; ++y) {
+        fwrite(&field[(size_t)y*w], w, 1, out);
+        fputc('\n', out);
+    }
+    if( 0 != fclose(out) ) {
+        log_printf("Error writing %s\n", fname.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Generates a text maze file for scaling tests, loadable via `pacman -maze <file>`,
+ * and validates it by loading.
+ */
+int main(int argc, char *argv[])
+{
+    if( 4 > argc ) {
+        fprintf(stderr, "Usage: %s <width> <height> <maze-text-file> [seed]\n", argv[0]);
+        return 1;
+    }
+    const int w = atoi(argv[1]);
+    const int h = atoi(argv[2]);
+    const unsigned int seed = 5 <= argc ? (unsigned int)atoi(argv[4]) : 1;
+    if( w < 28 || h < 36 || w > maze_t::field_t::max_dim || h > maze_t::field_t::max_dim ) {
+        fprintf(stderr, "Dimension %d x %d out of range [28 x 36 .. %d x %d]\n", w, h, maze_t::field_t::max_dim, maze_t::field_t::max_dim);
+        return 1;
+    }
+    if( !generate(argv[3], w, h, seed) ) {
+        return 1;
+    }
+    const uint64_t t0 = getCurrentMilliseconds();
+    global_maze = std::make_unique<maze_t>(argv[3]);
+    const uint64_t t1 = getCurrentMilliseconds();
+    if( !global_maze->is_ok() ) {
+        log_printf("Maze: Error: %s\n", global_maze->toString().c_str());
+        return 1;
+    }
+    int unreachable = 0;
+    for(int y=0; y<h; ++y) {
+        for(int x=0; x<w; ++x) {
+            const tile_t t = global_maze->tile(x, y);
+            if( ( tile_t::PELLET == t || tile_t::PELLET_POWER == t ) && 0 > global_maze->home_distance(x, y) ) {
+                ++unreachable;
+            }
+        }
+    }
+    log_printf("Maze: %s, loaded in %" PRIu64 " ms\n", global_maze->toString().c_str(), t1-t0);
+    if( 0 < unreachable ) {
+        log_printf("Maze: Error: %d unreachable pellets\n", unreachable);
+        return 1;
+    }
+    return 0;
+}
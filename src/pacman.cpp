@@ -27,6 +27,7 @@
 #include <pacman/globals.hpp>
 
 #include <limits>
+#include <algorithm>
 
 #include <cstdio>
 #include <time.h>
@@ -39,7 +40,7 @@ static constexpr const bool DEBUG_GFX_BOUNDS = false;
 
 std::vector<int> pacman_t::rgb_color = { 0xff, 0xff, 0x00 };
 
-random_engine_t<random_engine_mode_t::STD_RNG> pacman_t::rng_hw;
+random_engine_t<random_engine_mode_t::STD_PRNG_0> pacman_t::rng_fruit;
 
 animtex_t& pacman_t::get_tex() noexcept {
     switch( mode_ ) {
@@ -99,7 +100,7 @@ pacman_t::pacman_t(SDL_Renderer* rend, const float fields_per_sec_total_) noexce
   atex_dead( "X", rend, ms_per_tex, global_tex->all_images(), 0, 14, 14, 14, {
           { 0*14, 0 }, { 1*14, 0 }, { 2*14, 0 }, { 3*14, 0 }, { 4*14, 0 }, { 5*14, 0 },
           { 6*14, 0 }, { 7*14, 0 }, { 8*14, 0 }, { 9*14, 0 }, { 10*14, 0 }, { 11*14, 0 } }),
-  atex_home( "H", ms_per_tex, { atex_dead.texture(0) }),
+  atex_home( "H", ms_per_tex, { atex_dead.handle(0) }),
   atex( &atex_home ),
   pos_( global_maze->pacman_start_pos() )
 {
@@ -131,6 +132,15 @@ void pacman_t::set_mode(const mode_t m, const int mode_ms) noexcept {
             stop_audio_loops();
             break;
         case mode_t::LEVEL_SETUP: {
+            // drop the previous level's state as after construction, making each level start a replayable restart point
+            mode_last = mode_t::NORMAL;
+            mode_last_ms_left = -1;
+            ghosts_eaten_powered = 0;
+            current_speed_pct = 0.0f;
+            keyframei_.reset(get_frames_per_sec(), 0.0f, true /* nearest */);
+            sync_next_frame_cntr.reset( keyframei_.sync_frame_count(), true /* auto_reload */);
+            next_empty_field_frame_cntr.reset(0, false /* auto_reload */);
+            current_dir = direction_t::LEFT;
             stop_audio_loops();
             atex = &get_tex();
             ghost_t::set_global_mode(ghost_t::mode_t::LEVEL_SETUP);
@@ -162,7 +172,7 @@ void pacman_t::set_mode(const mode_t m, const int mode_ms) noexcept {
             stop_audio_loops();
             atex_dead.reset();
             ghost_t::set_global_mode(ghost_t::mode_t::PACMAN_DIED);
-            audio_samples[ ::number( audio_clip_t::DEATH ) ]->play();
+            audio_play( audio_clip_t::DEATH );
             break;
         default:
             break;
@@ -176,7 +186,7 @@ void pacman_t::set_mode(const mode_t m, const int mode_ms) noexcept {
 }
 
 void pacman_t::stop_audio_loops() noexcept {
-    audio_samples[ ::number( audio_clip_t::MUNCH ) ]->stop();
+    audio_stop( audio_clip_t::MUNCH );
 }
 
 void pacman_t::set_speed(const float pct) noexcept {
@@ -195,18 +205,18 @@ void pacman_t::set_speed(const float pct) noexcept {
 
 void pacman_t::print_stats() noexcept {
     const acoord_t::stats_t &stats = pos_.get_stats();
-    if( perf_frame_count_walked >= (uint64_t) keyframei_.frames_per_second() ) {
+    if( perf_tick_count_walked >= (uint64_t) keyframei_.frames_per_second() ) {
         const uint64_t t1 = getCurrentMilliseconds();
         const uint64_t td = t1-perf_fields_walked_t0;
         const float fields_per_seconds = get_fps(perf_fields_walked_t0, t1, stats.fields_walked_f);
         const float fields_per_seconds_req = keyframei_.fields_per_second_requested();
         const float fields_per_seconds_diff_pct = ( std::abs(fields_per_seconds_req - fields_per_seconds ) / fields_per_seconds_req ) * 100.0f;
-        const float fps_draw = get_fps(perf_fields_walked_t0, t1, perf_frame_count_walked);
-        const float fps_tick = get_fps(perf_fields_walked_t0, t1, perf_frame_count_walked - sync_next_frame_cntr.events());
-        log_printf("pacman stats: speed %.2f%, td %" PRIu64 "ms, fields[%.2f walked, actual %.3f/s, requested %.3f/s, diff %.4f%], fps[draw %.2f/s, tick %.2f/s], frames[draw %" PRIu64 ", synced %d], %s, %s\n",
+        const float tps_all = get_fps(perf_fields_walked_t0, t1, perf_tick_count_walked);
+        const float tps_moved = get_fps(perf_fields_walked_t0, t1, perf_tick_count_walked - sync_next_frame_cntr.events());
+        log_printf("pacman stats: speed %.2f%, td %" PRIu64 "ms, fields[%.2f walked, actual %.3f/s, requested %.3f/s, diff %.4f%], tps[all %.2f/s, moved %.2f/s], ticks[all %" PRIu64 ", synced %d], %s, %s\n",
                 current_speed_pct, td,
                 stats.fields_walked_f, fields_per_seconds, fields_per_seconds_req, fields_per_seconds_diff_pct,
-                fps_draw, fps_tick, perf_frame_count_walked, sync_next_frame_cntr.events(),
+                tps_all, tps_moved, perf_tick_count_walked, sync_next_frame_cntr.events(),
                 keyframei_.toString().c_str(), pos_.toString().c_str());
     }
 }
@@ -216,7 +226,7 @@ void pacman_t::reset_stats() noexcept {
         print_stats();
     }
     perf_fields_walked_t0 = getCurrentMilliseconds();
-    perf_frame_count_walked = 0;
+    perf_tick_count_walked = 0;
     pos_.reset_stats();
     sync_next_frame_cntr.reset( keyframei_.sync_frame_count(), true /* auto_reload */);
 }
@@ -246,6 +256,7 @@ bool pacman_t::set_dir(const direction_t new_dir) noexcept {
 }
 
 bool pacman_t::tick() noexcept {
+    ++perf_tick_count_walked;
     atex = &get_tex();
     atex->tick();
 
@@ -326,14 +337,14 @@ bool pacman_t::tick() noexcept {
                     collision_maze, collision_enemies, atex->toString().c_str());
         }
         if( collision_maze ) {
-            audio_samples[ ::number( audio_clip_t::MUNCH ) ]->stop();
+            audio_stop( audio_clip_t::MUNCH );
             reset_stats();
         } else { // if( entered_tile ) {
             if( tile_t::PELLET <= tile && tile <= tile_t::KEY ) {
                 if( tile_t::PELLET == tile ) {
                     global_maze->set_tile(x_i, y_i, tile_t::EMPTY);
                     score_ += ::number( tile_to_score(tile) );
-                    audio_samples[ ::number( audio_clip_t::MUNCH ) ]->play(0);
+                    audio_play( audio_clip_t::MUNCH, 0 );
                     if( mode_t::POWERED == mode_ ) {
                         set_speed(game_level_spec().pacman_powered_speed_dots);
                     } else {
@@ -348,7 +359,7 @@ bool pacman_t::tick() noexcept {
                         const acoord_t& f_p = global_maze->fruit_pos();
                         const tile_t fruit = game_level_spec().symbol;
                         global_maze->set_tile(f_p.x_i(), f_p.y_i(), fruit);
-                        fruit_ms_left = fruit_duration_min + ( rng_hw() % ( fruit_duration_max - fruit_duration_min + 1 ) );
+                        fruit_ms_left = fruit_duration_min + ( rng_fruit() % ( fruit_duration_max - fruit_duration_min + 1 ) );
                         if( log_modes() ) {
                             log_printf("fruit appears: tile %s, dur %dms\n", to_string( fruit ).c_str(), fruit_ms_left);
                         }
@@ -357,7 +368,7 @@ bool pacman_t::tick() noexcept {
                     global_maze->set_tile(x_i, y_i, tile_t::EMPTY);
                     score_ += ::number( tile_to_score(tile) );
                     set_mode( mode_t::POWERED, game_level_spec().fright_time_ms );
-                    audio_samples[ ::number( audio_clip_t::MUNCH ) ]->play(0);
+                    audio_play( audio_clip_t::MUNCH, 0 );
                     next_empty_field_frame_cntr.load( keyframei_.frames_per_field() + 1 );
                     ghosts_eaten_powered = 0;
                     freeze_frame_count = 3;
@@ -369,7 +380,7 @@ bool pacman_t::tick() noexcept {
                     } else {
                         set_speed(game_level_spec().pacman_speed);
                     }
-                    audio_samples[ ::number( audio_clip_t::MUNCH ) ]->stop();
+                    audio_stop( audio_clip_t::MUNCH );
                 }
             }
             if( is_center ) {
@@ -382,7 +393,7 @@ bool pacman_t::tick() noexcept {
                     score_ += freeze_score;
                     freeze_box_.set(f_p.x_i()-1, f_p.y_i()-1, 2, 2);
                     set_mode(mode_t::FREEZE, number( mode_duration_t::FREEZE ));
-                    audio_samples[ ::number( audio_clip_t::EAT_FRUIT) ]->play();
+                    audio_play( audio_clip_t::EAT_FRUIT );
                     if( log_modes() ) {
                         log_printf("pacman eats: a fruit: score %d, tile [pos %s, fpos %s], left %dms, pos[self %s, fruit %s]\n",
                                 freeze_score, to_string(tile).c_str(), to_string(fruit_tile).c_str(), fruit_ms_left,
@@ -392,11 +403,14 @@ bool pacman_t::tick() noexcept {
             }
         }
     }
-    // Collision test with ghosts
-    int i=0;
-    for(ghost_ref g : ghosts()) {
-        if( pos_.intersects_f(g->position()) ) {
-            const ghost_t::mode_t g_mode = g->mode();
+    // Collision test with ghosts, visiting only those within the neighboring tiles, in ghosts() order
+    collision_candidates.clear();
+    ghost_t::occupancy().for_each_in_box(pos_.x_i()-1, pos_.y_i()-1, 3, 3, [&](const int i) { collision_candidates.push_back(i); });
+    std::sort(collision_candidates.begin(), collision_candidates.end());
+    for(const int i : collision_candidates) {
+        ghost_t& g = ghosts()[i];
+        if( pos_.intersects_f(g.position()) ) {
+            const ghost_t::mode_t g_mode = g.mode();
             if( ghost_t::mode_t::CHASE <= g_mode && g_mode <= ghost_t::mode_t::SCATTER ) {
                 if( !invincible ) {
                     collision_enemies = true;
@@ -410,17 +424,16 @@ bool pacman_t::tick() noexcept {
                 }
                 score_ += freeze_score;
                 ++ghosts_eaten_powered;
-                g->set_mode( ghost_t::mode_t::PHANTOM );
-                audio_samples[ ::number( audio_clip_t::MUNCH ) ]->stop();
-                audio_samples[ ::number( audio_clip_t::EAT_GHOST ) ]->play();
+                g.set_mode( ghost_t::mode_t::PHANTOM );
+                audio_stop( audio_clip_t::MUNCH );
+                audio_play( audio_clip_t::EAT_GHOST );
                 freeze_box_.set(pos_.x_i()-1, pos_.y_i()-1, 2, 2);
                 set_mode(mode_t::FREEZE, number( mode_duration_t::FREEZE ));
                 if( log_modes() ) {
-                    log_printf("pacman eats: ghost# %d, score %d, ghost %s\n", ghosts_eaten_powered, freeze_score, g->toString().c_str());
+                    log_printf("pacman eats: ghost# %d, score %d, ghost %s\n", ghosts_eaten_powered, freeze_score, g.toString().c_str());
                 }
             }
         }
-        ++i;
     }
 
     if( collision_enemies ) {
@@ -429,29 +442,36 @@ bool pacman_t::tick() noexcept {
     return true; // return false after DEAD animation, not yet: !collision_enemies;
 }
 
-void pacman_t::draw(SDL_Renderer* rend) noexcept {
-    ++perf_frame_count_walked;
+pacman_t::snapshot_t pacman_t::get_snapshot() const noexcept {
+    return snapshot_t { .tex=atex->handle(), .pos={ pos_.x_f(), pos_.y_f(), pos_.x_f(), pos_.y_f() }, .center=keyframei_.center(),
+                        .freeze=mode_t::FREEZE == mode_, .freeze_score=freeze_score };
+}
+
+void pacman_t::draw(SDL_Renderer* rend, const snapshot_t& s, const float alpha) noexcept {
+    float pos_x, pos_y;
+    s.pos.interpolate(alpha, pos_x, pos_y);
+    const tex_region_t tex = get_tex_region(s.tex);
 
-    if( mode_t::FREEZE == mode_ ) {
-        if( 0 <= freeze_score ) {
-            draw_text_scaled(rend, font_ttf(), std::to_string( freeze_score ), 255, 255, 255, true /* cache */, [&](const texture_t& tex, int &x, int&y) {
-                x = round_to_int( pos_.x_f() * global_maze->ppt_y() * win_pixel_scale() ) - tex.width()  / 2;
-                y = round_to_int( pos_.y_f() * global_maze->ppt_y() * win_pixel_scale() ) - tex.height() / 2;
+    if( s.freeze ) {
+        if( 0 <= s.freeze_score ) {
+            draw_text_scaled(rend, font_ttf(), std::to_string( s.freeze_score ), 255, 255, 255, true /* cache */, [&](const texture_t& tex, int &x, int&y) {
+                x = win_viewport().x_to_pixel( pos_x ) - tex.width()  / 2;
+                y = win_viewport().y_to_pixel( pos_y ) - tex.height() / 2;
             });
         }
     } else {
-        atex->draw2(rend, pos_.x_f()-keyframei_.center(), pos_.y_f()-keyframei_.center());
+        tex.draw2_f(rend, pos_x-s.center, pos_y-s.center);
     }
 
-    if( show_debug_gfx() || DEBUG_GFX_BOUNDS ) {
+    if( ( show_debug_gfx() || DEBUG_GFX_BOUNDS ) && tex.is_valid() ) {
         uint8_t r, g, b, a;
         SDL_GetRenderDrawColor(rend, &r, &g, &b, &a);
         SDL_SetRenderDrawColor(rend, rgb_color[0], rgb_color[1], rgb_color[2], 255);
-        const int win_pixel_offset = ( win_pixel_width() - global_maze->pixel_width()*win_pixel_scale() ) / 2;
+        const viewport_t& vp = win_viewport();
         // pos is on player center position
-        SDL_Rect bounds = { .x=win_pixel_offset + round_to_int( pos_.x_f() * global_maze->ppt_y() * win_pixel_scale() ) - ( atex->width()  * win_pixel_scale() ) / 2,
-                            .y=                   round_to_int( pos_.y_f() * global_maze->ppt_y() * win_pixel_scale() ) - ( atex->height() * win_pixel_scale() ) / 2,
-                            .w=atex->width()*win_pixel_scale(), .h=atex->height()*win_pixel_scale() };
+        SDL_Rect bounds = { .x=vp.offset_x() + vp.x_to_pixel( pos_x ) - vp.scaled( tex.width  ) / 2,
+                            .y=                vp.y_to_pixel( pos_y ) - vp.scaled( tex.height ) / 2,
+                            .w=vp.scaled( tex.width ), .h=vp.scaled( tex.height ) };
         SDL_RenderDrawRect(rend, &bounds);
         SDL_SetRenderDrawColor(rend, r, g, b, a);
     }
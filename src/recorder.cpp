@@ -0,0 +1,878 @@
+/*
+ * Author: Sven Gothel <sgothel@jausoft.com> and Svenson Han Gothel
+ * Copyright (c) 2022 Gothel Software e.K.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <pacman/recorder.hpp>
+#include <pacman/utils.hpp>
+
+#include <SDL2/SDL_image.h>
+
+#include <cstring>
+
+static constexpr const bool DEBUG_LOG = false;
+
+//
+// record_policy_t
+//
+
+std::string to_string(const record_policy_t p) noexcept {
+    switch( p ) {
+        case record_policy_t::BLOCK: return "block";
+        case record_policy_t::DROP: return "drop";
+        case record_policy_t::DEGRADE: return "degrade";
+    }
+    return "unknown";
+}
+
+bool to_record_policy(const std::string& name, record_policy_t& policy) noexcept {
+    if( "block" == name ) {
+        policy = record_policy_t::BLOCK;
+    } else if( "drop" == name ) {
+        policy = record_policy_t::DROP;
+    } else if( "degrade" == name ) {
+        policy = record_policy_t::DEGRADE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+//
+// record_format_t
+//
+
+std::string to_string(const record_format_t f) noexcept {
+    switch( f ) {
+        case record_format_t::BMP: return "bmp";
+        case record_format_t::PNG: return "png";
+        case record_format_t::QOI: return "qoi";
+    }
+    return "unknown";
+}
+
+bool to_record_format(const std::string& name, record_format_t& format) noexcept {
+    if( "bmp" == name ) {
+        format = record_format_t::BMP;
+    } else if( "png" == name ) {
+        format = record_format_t::PNG;
+    } else if( "qoi" == name ) {
+        format = record_format_t::QOI;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+//
+// stripe_pool_t
+//
+
+stripe_pool_t::stripe_pool_t(const size_t thread_count) noexcept
+: running_(true)
+{
+    const size_t n = 0 < thread_count ? thread_count : std::max<size_t>(1, std::thread::hardware_concurrency()) - 1;
+    for(size_t i=0; i<n; ++i) {
+        threads_.emplace_back(&stripe_pool_t::thread_main, this);
+    }
+}
+
+stripe_pool_t::~stripe_pool_t() noexcept {
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        running_ = false;
+    }
+    cv_tasks_.notify_all();
+    for(std::thread& t : threads_) {
+        t.join();
+    }
+}
+
+void stripe_pool_t::execute(std::unique_lock<std::mutex>& lock, const task_t& t) noexcept {
+    lock.unlock();
+    (*t.batch->fn)(t.idx);
+    lock.lock();
+    if( 0 == --t.batch->left ) {
+        cv_done_.notify_all();
+    }
+}
+
+void stripe_pool_t::thread_main() noexcept {
+    std::unique_lock<std::mutex> lock(mtx_);
+    for(;;) {
+        cv_tasks_.wait(lock, [&]{ return !tasks_.empty() || !running_; });
+        if( tasks_.empty() ) {
+            return; // stopped
+        }
+        const task_t t = tasks_.front();
+        tasks_.pop_front();
+        execute(lock, t);
+    }
+}
+
+void stripe_pool_t::run(const int count, const std::function<void(int)>& fn) noexcept {
+    if( 0 >= count ) {
+        return;
+    }
+    batch_t batch { &fn, count };
+    std::unique_lock<std::mutex> lock(mtx_);
+    for(int i=1; i<count; ++i) {
+        tasks_.push_back( task_t { &batch, i } );
+    }
+    if( 1 < count ) {
+        cv_tasks_.notify_all();
+    }
+    // the first stripe on the calling thread, then helping with the queued ones
+    execute(lock, task_t { &batch, 0 });
+    while( 0 < batch.left ) {
+        if( !tasks_.empty() ) {
+            const task_t t = tasks_.front();
+            tasks_.pop_front();
+            execute(lock, t);
+        } else {
+            cv_done_.wait(lock, [&]{ return 0 == batch.left || !tasks_.empty(); });
+        }
+    }
+}
+
+//
+// bmp_writer_t
+//
+
+bool bmp_writer_t::write(SDL_Surface* frame, const std::string& fname, const uint64_t frame_no) noexcept {
+    (void)frame_no;
+    if( 0 != SDL_SaveBMP(frame, fname.c_str()) ) {
+        log_printf("bmp_writer: Error writing %s: %s\n", fname.c_str(), SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+//
+// png_writer_t
+//
+
+bool png_writer_t::write(SDL_Surface* frame, const std::string& fname, const uint64_t frame_no) noexcept {
+    (void)frame_no;
+    if( 0 != IMG_SavePNG(frame, fname.c_str()) ) {
+        log_printf("png_writer: Error writing %s: %s\n", fname.c_str(), SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+//
+// qoi_writer_t
+//
+
+static constexpr const uint8_t QOI_OP_INDEX = 0x00;
+static constexpr const uint8_t QOI_OP_DIFF  = 0x40;
+static constexpr const uint8_t QOI_OP_LUMA  = 0x80;
+static constexpr const uint8_t QOI_OP_RUN   = 0xc0;
+static constexpr const uint8_t QOI_OP_RGB   = 0xfe;
+
+static inline int qoi_hash(const uint32_t argb) noexcept {
+    const int a = ( argb >> 24 ) & 0xff, r = ( argb >> 16 ) & 0xff, g = ( argb >> 8 ) & 0xff, b = argb & 0xff;
+    return ( r*3 + g*5 + b*7 + a*11 ) % 64;
+}
+
+/**
+ * Encodes the QOI ops of the given ARGB8888 rows [y0, y1) as opaque RGB,
+ * as the alpha byte of a render read back is undefined.
+ *
+ * With alpha forced to 0xff, the decoder's alpha is constant.
+ * The stripe's first pixel is always stored as QOI_OP_RGB unless y0 is zero,
+ * and QOI_OP_INDEX only references colors indexed within the stripe.
+ * Hence the stripe is independent of the decoder state left by the previous stripe.
+ */
+static void qoi_encode_stripe(const SDL_Surface* frame, const int y0, const int y1, std::vector<uint8_t>& out) noexcept {
+    uint32_t index[64] = { 0 };
+    uint64_t indexed = 0; // bit i set if index[i] has been written within this stripe
+    uint32_t prev = 0xff000000;
+    bool has_prev = 0 == y0; // first stripe starts with the decoder's initial state
+    int run = 0;
+
+    out.clear();
+    out.reserve( (size_t)frame->w * (y1 - y0) );
+    for(int y=y0; y<y1; ++y) {
+        const uint32_t* row = reinterpret_cast<const uint32_t*>( static_cast<const uint8_t*>(frame->pixels) + (size_t)y * frame->pitch );
+        for(int x=0; x<frame->w; ++x) {
+            const uint32_t px = row[x] | 0xff000000;
+            if( has_prev && px == prev ) {
+                if( 62 == ++run ) {
+                    out.push_back( QOI_OP_RUN | ( run - 1 ) );
+                    run = 0;
+                }
+                continue;
+            }
+            if( 0 < run ) {
+                out.push_back( QOI_OP_RUN | ( run - 1 ) );
+                run = 0;
+            }
+            const int h = qoi_hash(px);
+            const int r = ( px >> 16 ) & 0xff, g = ( px >> 8 ) & 0xff, b = px & 0xff;
+            if( has_prev && 0 != ( indexed & ( 1ULL << h ) ) && index[h] == px ) {
+                out.push_back( QOI_OP_INDEX | h );
+            } else {
+                index[h] = px;
+                indexed |= 1ULL << h;
+                if( has_prev ) {
+                    const int vr = (int8_t)( r - (int)( ( prev >> 16 ) & 0xff ) );
+                    const int vg = (int8_t)( g - (int)( ( prev >>  8 ) & 0xff ) );
+                    const int vb = (int8_t)( b - (int)(   prev         & 0xff ) );
+                    const int vg_r = vr - vg;
+                    const int vg_b = vb - vg;
+                    if( -3 < vr && vr < 2 && -3 < vg && vg < 2 && -3 < vb && vb < 2 ) {
+                        out.push_back( QOI_OP_DIFF | ( vr + 2 ) << 4 | ( vg + 2 ) << 2 | ( vb + 2 ) );
+                    } else if( -9 < vg_r && vg_r < 8 && -33 < vg && vg < 32 && -9 < vg_b && vg_b < 8 ) {
+                        out.push_back( QOI_OP_LUMA | ( vg + 32 ) );
+                        out.push_back( ( vg_r + 8 ) << 4 | ( vg_b + 8 ) );
+                    } else {
+                        out.insert( out.end(), { QOI_OP_RGB, (uint8_t)r, (uint8_t)g, (uint8_t)b } );
+                    }
+                } else {
+                    out.insert( out.end(), { QOI_OP_RGB, (uint8_t)r, (uint8_t)g, (uint8_t)b } );
+                }
+            }
+            prev = px;
+            has_prev = true;
+        }
+    }
+    if( 0 < run ) {
+        out.push_back( QOI_OP_RUN | ( run - 1 ) );
+    }
+}
+
+bool qoi_writer_t::write(SDL_Surface* frame, const std::string& fname, const uint64_t frame_no) noexcept {
+    (void)frame_no;
+    const int stripe_count = std::max(1, std::min<int>( (int)pool_.size(), frame->h / 16 ));
+    const int rows_per_stripe = ( frame->h + stripe_count - 1 ) / stripe_count;
+    std::vector<std::vector<uint8_t>> stripes( stripe_count );
+    pool_.run(stripe_count, [&](int i) {
+        const int y0 = std::min(frame->h, i * rows_per_stripe);
+        const int y1 = std::min(frame->h, y0 + rows_per_stripe);
+        qoi_encode_stripe(frame, y0, y1, stripes[i]);
+    });
+
+    FILE* out = fopen(fname.c_str(), "wb");
+    if( nullptr == out ) {
+        log_printf("qoi_writer: Error opening %s\n", fname.c_str());
+        return false;
+    }
+    const uint32_t w = (uint32_t)frame->w, h = (uint32_t)frame->h;
+    const uint8_t header[14] = { 'q', 'o', 'i', 'f',
+                                 (uint8_t)( w >> 24 ), (uint8_t)( w >> 16 ), (uint8_t)( w >> 8 ), (uint8_t)w,
+                                 (uint8_t)( h >> 24 ), (uint8_t)( h >> 16 ), (uint8_t)( h >> 8 ), (uint8_t)h,
+                                 3 /* RGB */, 0 /* sRGB */ };
+    const uint8_t end_marker[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    bool ok = 1 == fwrite(header, sizeof(header), 1, out);
+    for(const std::vector<uint8_t>& stripe : stripes) {
+        ok = ok && stripe.size() == fwrite(stripe.data(), 1, stripe.size(), out);
+    }
+    ok = ok && 1 == fwrite(end_marker, sizeof(end_marker), 1, out);
+    ok = 0 == fclose(out) && ok;
+    if( !ok ) {
+        log_printf("qoi_writer: Error writing %s\n", fname.c_str());
+    }
+    return ok;
+}
+
+std::unique_ptr<frame_writer_t> make_image_writer(const record_format_t format, stripe_pool_t* pool) noexcept {
+    switch( format ) {
+        case record_format_t::PNG: return std::make_unique<png_writer_t>();
+        case record_format_t::QOI: return std::make_unique<qoi_writer_t>(*pool);
+        default: return std::make_unique<bmp_writer_t>();
+    }
+}
+
+//
+// y4m_writer_t
+//
+
+y4m_writer_t::y4m_writer_t(const std::string& fname, const int fps) noexcept
+: fname_(fname), out_(nullptr), fps_(std::max(1, fps)), width_(0), height_(0), frames_skipped_(0)
+{
+    if( "-" == fname_ ) {
+        out_ = stdout;
+    } else {
+        out_ = fopen(fname_.c_str(), "wb");
+    }
+    if( nullptr == out_ ) {
+        log_printf("y4m_writer: Error opening %s\n", fname_.c_str());
+    }
+}
+
+y4m_writer_t::~y4m_writer_t() noexcept {
+    if( nullptr != out_ ) {
+        if( stdout == out_ ) {
+            fflush(out_);
+        } else {
+            fclose(out_);
+        }
+        out_ = nullptr;
+    }
+}
+
+/** Fixed point BT.601 limited range RGB to YCbCr, see ITU-R BT.601 */
+static inline uint8_t rgb_to_y(const int r, const int g, const int b) noexcept {
+    return static_cast<uint8_t>( ( (  66*r + 129*g +  25*b + 128 ) >> 8 ) +  16 );
+}
+static inline uint8_t rgb_to_u(const int r, const int g, const int b) noexcept {
+    return static_cast<uint8_t>( ( ( -38*r -  74*g + 112*b + 128 ) >> 8 ) + 128 );
+}
+static inline uint8_t rgb_to_v(const int r, const int g, const int b) noexcept {
+    return static_cast<uint8_t>( ( ( 112*r -  94*g -  18*b + 128 ) >> 8 ) + 128 );
+}
+
+bool y4m_writer_t::write(SDL_Surface* frame, const std::string& fname, const uint64_t frame_no) noexcept {
+    (void)fname;
+    (void)frame_no;
+    if( nullptr == out_ ) {
+        return false;
+    }
+    int width = width_.load(std::memory_order_relaxed);
+    int height = height_.load(std::memory_order_relaxed);
+    if( 0 == width ) {
+        width = frame->w;
+        height = frame->h;
+        height_.store(height, std::memory_order_relaxed);
+        width_.store(width, std::memory_order_release);
+        planes_.resize( 3 * (size_t)width * (size_t)height );
+        fprintf(out_, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, fps_);
+    } else if( width != frame->w || height != frame->h ) {
+        if( 0 == frames_skipped_++ ) {
+            log_printf("y4m_writer: Skipping %d x %d frames, stream is %d x %d\n", frame->w, frame->h, width, height);
+        }
+        return false;
+    }
+    const size_t plane_size = (size_t)width * (size_t)height;
+    uint8_t* py = planes_.data();
+    uint8_t* pu = py + plane_size;
+    uint8_t* pv = pu + plane_size;
+    for(int y=0; y<height; ++y) {
+        const uint32_t* row = reinterpret_cast<const uint32_t*>( static_cast<const uint8_t*>(frame->pixels) + (size_t)y * frame->pitch );
+        for(int x=0; x<width; ++x) {
+            const uint32_t argb = row[x];
+            const int r = ( argb >> 16 ) & 0xff;
+            const int g = ( argb >>  8 ) & 0xff;
+            const int b =   argb         & 0xff;
+            *py++ = rgb_to_y(r, g, b);
+            *pu++ = rgb_to_u(r, g, b);
+            *pv++ = rgb_to_v(r, g, b);
+        }
+    }
+    fputs("FRAME\n", out_);
+    return planes_.size() == fwrite(planes_.data(), 1, planes_.size(), out_);
+}
+
+std::string y4m_writer_t::toString() const noexcept {
+    // called by the rendering thread while the writer thread may set the dimension
+    const int width = width_.load(std::memory_order_acquire);
+    const int height = height_.load(std::memory_order_relaxed);
+    return "y4m["+fname_+", "+std::to_string(width)+"x"+std::to_string(height)+" @ "+std::to_string(fps_)+
+           " fps, skipped "+std::to_string(frames_skipped_)+"]";
+}
+
+//
+// delta_writer_t
+//
+
+/** 64-bit FNV-1a variant hashing 64-bit words */
+static uint64_t hash_pixels(const uint32_t* pixels, const size_t count) noexcept {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    size_t i = 0;
+    for(; i+1 < count; i+=2) {
+        h = ( h ^ ( (uint64_t)pixels[i] | ( (uint64_t)pixels[i+1] << 32 ) ) ) * 0x100000001b3ULL;
+    }
+    if( i < count ) {
+        h = ( h ^ pixels[i] ) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+delta_writer_t::delta_writer_t(const std::string& fname, const int fps) noexcept
+: fname_(fname), out_( fopen(fname.c_str(), "wb") ), fps_(std::max(1, fps)), width_(0), height_(0),
+  prev_hash_(0), last_frame_no_(0), last_elided_(false),
+  frames_stored_(0), frames_elided_(0), frames_skipped_(0), bytes_written_(0)
+{
+    if( nullptr == out_ ) {
+        log_printf("delta_writer: Error opening %s\n", fname_.c_str());
+    }
+}
+
+delta_writer_t::~delta_writer_t() noexcept {
+    if( nullptr != out_ ) {
+        if( last_elided_ ) {
+            // keep the duration of trailing duplicates
+            const uint32_t no_rects = 0;
+            fwrite(&last_frame_no_, sizeof(last_frame_no_), 1, out_);
+            fwrite(&no_rects, sizeof(no_rects), 1, out_);
+        }
+        fclose(out_);
+        out_ = nullptr;
+    }
+}
+
+bool delta_writer_t::write_frame(const uint64_t frame_no, const uint32_t* pixels) noexcept {
+    const uint32_t rect_count = static_cast<uint32_t>( rects_.size() );
+    const int width = width_.load(std::memory_order_relaxed);
+    bool ok = 1 == fwrite(&frame_no, sizeof(frame_no), 1, out_) &&
+              1 == fwrite(&rect_count, sizeof(rect_count), 1, out_);
+    bytes_written_ += sizeof(frame_no) + sizeof(rect_count);
+    for(const delta_rect_t& r : rects_) {
+        ok = ok && 1 == fwrite(&r, sizeof(r), 1, out_);
+        for(uint32_t y=r.y; ok && y<r.y+r.height; ++y) {
+            ok = r.width == fwrite(pixels + (size_t)y * width + r.x, sizeof(uint32_t), r.width, out_);
+        }
+        bytes_written_ += sizeof(r) + (size_t)r.width * r.height * sizeof(uint32_t);
+    }
+    ++frames_stored_;
+    return ok;
+}
+
+bool delta_writer_t::write(SDL_Surface* frame, const std::string& fname, const uint64_t frame_no) noexcept {
+    (void)fname;
+    if( nullptr == out_ ) {
+        return false;
+    }
+    int width = width_.load(std::memory_order_relaxed);
+    int height = height_.load(std::memory_order_relaxed);
+    if( 0 == width ) {
+        width = frame->w;
+        height = frame->h;
+        height_.store(height, std::memory_order_relaxed);
+        width_.store(width, std::memory_order_release);
+        prev_.resize( (size_t)width * (size_t)height );
+        cur_.resize( prev_.size() );
+        const uint32_t header[] = { (uint32_t)width, (uint32_t)height, (uint32_t)fps_ };
+        fwrite(magic, 1, 8, out_);
+        fwrite(header, sizeof(header), 1, out_);
+    } else if( width != frame->w || height != frame->h ) {
+        if( 0 == frames_skipped_++ ) {
+            log_printf("delta_writer: Skipping %d x %d frames, stream is %d x %d\n", frame->w, frame->h, width, height);
+        }
+        return false;
+    }
+    // tightly packed copy of the current frame
+    std::vector<uint32_t>& cur = cur_;
+    for(int y=0; y<height; ++y) {
+        memcpy(cur.data() + (size_t)y * width, static_cast<const uint8_t*>(frame->pixels) + (size_t)y * frame->pitch, width * sizeof(uint32_t));
+    }
+    const uint64_t hash = hash_pixels(cur.data(), cur.size());
+    last_frame_no_ = frame_no;
+    // a hash collision must not lose a changed frame, hence compare a matching hash's frame
+    if( 0 < frames_stored_ && hash == prev_hash_ && 0 == memcmp(cur.data(), prev_.data(), cur.size() * sizeof(uint32_t)) ) {
+        ++frames_elided_;
+        last_elided_ = true;
+        return true;
+    }
+    last_elided_ = false;
+    prev_hash_ = hash;
+
+    rects_.clear();
+    if( 0 == frames_stored_ % key_interval ) {
+        rects_.push_back( delta_rect_t { 0, 0, (uint32_t)width, (uint32_t)height } );
+    } else {
+        // merge horizontally adjacent changed blocks of each block row
+        for(int by=0; by<height; by+=block_size) {
+            const int bh = std::min(block_size, height - by);
+            int run_x = -1;
+            for(int bx=0; bx<width; bx+=block_size) {
+                const int bw = std::min(block_size, width - bx);
+                bool dirty = false;
+                for(int y=by; !dirty && y<by+bh; ++y) {
+                    const size_t o = (size_t)y * width + bx;
+                    dirty = 0 != memcmp(cur.data() + o, prev_.data() + o, bw * sizeof(uint32_t));
+                }
+                if( dirty && 0 > run_x ) {
+                    run_x = bx;
+                } else if( !dirty && 0 <= run_x ) {
+                    rects_.push_back( delta_rect_t { (uint32_t)run_x, (uint32_t)by, (uint32_t)( bx - run_x ), (uint32_t)bh } );
+                    run_x = -1;
+                }
+            }
+            if( 0 <= run_x ) {
+                rects_.push_back( delta_rect_t { (uint32_t)run_x, (uint32_t)by, (uint32_t)( width - run_x ), (uint32_t)bh } );
+            }
+        }
+    }
+    const bool ok = write_frame(frame_no, cur.data());
+    prev_.swap(cur);
+    return ok;
+}
+
+std::string delta_writer_t::toString() const noexcept {
+    // called by the rendering thread while the writer thread may set the dimension
+    const int width = width_.load(std::memory_order_acquire);
+    const int height = height_.load(std::memory_order_relaxed);
+    return "delta["+fname_+", "+std::to_string(width)+"x"+std::to_string(height)+" @ "+std::to_string(fps_)+
+           " fps, stored "+std::to_string(frames_stored_)+", elided "+std::to_string(frames_elided_)+
+           ", skipped "+std::to_string(frames_skipped_)+", "+std::to_string(bytes_written_/1024)+" KiB]";
+}
+
+//
+// delta_reader_t
+//
+
+/** Upper bound of a delta stream's width and height, rejecting corrupt headers before allocating */
+static constexpr const uint32_t delta_max_dim = 1 << 14;
+
+delta_reader_t::delta_reader_t(const std::string& fname) noexcept
+: in_( fopen(fname.c_str(), "rb") ), width_(0), height_(0), fps_(0), frame_no_(0), frames_read_(0), error_(false)
+{
+    if( nullptr == in_ ) {
+        log_printf("delta_reader: Error opening %s\n", fname.c_str());
+        error_ = true;
+        return;
+    }
+    char m[8];
+    uint32_t header[3];
+    if( 1 != fread(m, sizeof(m), 1, in_) || 0 != memcmp(m, delta_writer_t::magic, sizeof(m)) ||
+        1 != fread(header, sizeof(header), 1, in_) )
+    {
+        fail("Invalid header");
+        return;
+    }
+    if( 0 == header[0] || delta_max_dim < header[0] || 0 == header[1] || delta_max_dim < header[1] || 0 == header[2] ) {
+        log_printf("delta_reader: Invalid header %u x %u @ %u fps in %s\n", header[0], header[1], header[2], fname.c_str());
+        fail("Invalid header");
+        return;
+    }
+    // the leading key frame covers the whole frame
+    const long frames_pos = ftell(in_);
+    const uint64_t key_frame_size = sizeof(uint64_t) + sizeof(uint32_t) + sizeof(delta_rect_t) +
+                                    (uint64_t)header[0] * header[1] * sizeof(uint32_t);
+    if( 0 != fseek(in_, 0, SEEK_END) || (uint64_t)( ftell(in_) - frames_pos ) < key_frame_size || 0 != fseek(in_, frames_pos, SEEK_SET) ) {
+        log_printf("delta_reader: File %s too small for a %u x %u key frame\n", fname.c_str(), header[0], header[1]);
+        fail("Truncated stream");
+        return;
+    }
+    width_ = (int)header[0];
+    height_ = (int)header[1];
+    fps_ = (int)header[2];
+    frame_.resize( (size_t)width_ * (size_t)height_, 0 );
+}
+
+delta_reader_t::~delta_reader_t() noexcept {
+    if( nullptr != in_ ) {
+        fclose(in_);
+        in_ = nullptr;
+    }
+}
+
+bool delta_reader_t::fail(const char* what) noexcept {
+    log_printf("delta_reader: %s at stored frame %" PRIu64 ", frame number %" PRIu64 "\n", what, frames_read_, frame_no_);
+    error_ = true;
+    if( nullptr != in_ ) {
+        fclose(in_);
+        in_ = nullptr;
+    }
+    return false;
+}
+
+bool delta_reader_t::next() noexcept {
+    if( nullptr == in_ ) {
+        return false;
+    }
+    uint64_t frame_no;
+    const size_t n = fread(&frame_no, 1, sizeof(frame_no), in_);
+    if( 0 == n && feof(in_) ) {
+        return false; // end of stream
+    }
+    uint32_t rect_count;
+    if( sizeof(frame_no) != n || 1 != fread(&rect_count, sizeof(rect_count), 1, in_) ) {
+        return fail("Truncated frame header");
+    }
+    if( 0 < frames_read_ && frame_no <= frame_no_ ) {
+        return fail("Non increasing frame number");
+    }
+    frame_no_ = frame_no;
+    for(uint32_t i=0; i<rect_count; ++i) {
+        delta_rect_t r;
+        if( 1 != fread(&r, sizeof(r), 1, in_) ) {
+            return fail("Truncated rectangle");
+        }
+        if( 0 == r.width || 0 == r.height || r.x >= (uint32_t)width_ || r.y >= (uint32_t)height_ ||
+            r.width > (uint32_t)width_ - r.x || r.height > (uint32_t)height_ - r.y )
+        {
+            return fail("Invalid rectangle");
+        }
+        if( 0 == frames_read_ && ( 1 != rect_count || r.width != (uint32_t)width_ || r.height != (uint32_t)height_ ) ) {
+            return fail("Missing leading key frame");
+        }
+        for(uint32_t y=r.y; y<r.y+r.height; ++y) {
+            if( r.width != fread(frame_.data() + (size_t)y * width_ + r.x, sizeof(uint32_t), r.width, in_) ) {
+                return fail("Truncated rectangle pixels");
+            }
+        }
+    }
+    if( 0 == frames_read_ && 0 == rect_count ) {
+        return fail("Missing leading key frame");
+    }
+    ++frames_read_;
+    return true;
+}
+
+//
+// frame_recorder_t
+//
+
+/** Maximum frame divisor of record_policy_t::DEGRADE */
+static constexpr const uint64_t degrade_nth_max = 16;
+
+frame_recorder_t::frame_recorder_t(std::unique_ptr<frame_writer_t> writer, const size_t buffer_count, const size_t worker_count, const record_policy_t policy) noexcept
+: policy_(policy), writer_( std::move(writer) ), buffers_( std::max<size_t>(1, buffer_count), nullptr ),
+  worker_count_( writer_->sequential() ? 1 : std::max<size_t>(1, worker_count) ), running_(true),
+  queue_depth_(0), queue_depth_max_(0), frames_written_(0), frames_dropped_(0), frames_failed_(0), frames_submitted_(0),
+  degrade_nth_(1), degrade_count_(0)
+{
+    for(size_t i=0; i<buffers_.size(); ++i) {
+        free_buffers_.push_back(i);
+    }
+}
+
+void frame_recorder_t::stop() noexcept {
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if( !running_ ) {
+            return;
+        }
+        running_ = false;
+    }
+    cv_queue_.notify_all();
+    for(std::thread& t : workers_) {
+        t.join();
+    }
+    workers_.clear();
+    for(SDL_Surface*& s : buffers_) {
+        if( nullptr != s ) {
+            SDL_FreeSurface(s);
+            s = nullptr;
+        }
+    }
+    if( 0 < frames_written() || 0 < frames_dropped() || 0 < frames_failed() ) {
+        log_printf("%s\n", toString().c_str());
+    }
+}
+
+void frame_recorder_t::worker_main() noexcept {
+    for(;;) {
+        job_t job;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_queue_.wait(lock, [&]{ return !queue_.empty() || !running_; });
+            if( queue_.empty() ) {
+                return; // stopped and drained
+            }
+            job = std::move( queue_.front() );
+            queue_.pop_front();
+        }
+        if( writer_->write(buffers_[job.buffer_idx], job.fname, job.frame_no) ) {
+            ++frames_written_;
+        } else {
+            ++frames_failed_; // logged by the writer
+        }
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            free_buffers_.push_back(job.buffer_idx);
+            --queue_depth_;
+        }
+        cv_free_.notify_one();
+    }
+}
+
+int frame_recorder_t::acquire(const int width, const int height) noexcept {
+    if( record_policy_t::DEGRADE == policy_ ) {
+        if( 1 < degrade_nth_ && 0 == queue_depth_ ) {
+            degrade_nth_ /= 2;
+        }
+        if( 0 != degrade_count_++ % degrade_nth_ ) {
+            ++frames_dropped_;
+            return -1;
+        }
+    }
+    size_t idx;
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if( free_buffers_.empty() ) {
+            switch( policy_ ) {
+                case record_policy_t::BLOCK:
+                    cv_free_.wait(lock, [&]{ return !free_buffers_.empty(); });
+                    break;
+                case record_policy_t::DEGRADE:
+                    degrade_nth_ = std::min(degrade_nth_ * 2, degrade_nth_max);
+                    [[fallthrough]];
+                case record_policy_t::DROP:
+                    ++frames_dropped_;
+                    return -1;
+            }
+        }
+        idx = free_buffers_.back();
+        free_buffers_.pop_back();
+    }
+    // A free buffer is exclusively owned by the rendering thread, (re)allocate on size change
+    SDL_Surface*& s = buffers_[idx];
+    if( nullptr != s && ( s->w != width || s->h != height ) ) {
+        SDL_FreeSurface(s);
+        s = nullptr;
+    }
+    if( nullptr == s ) {
+        s = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+        if( nullptr == s ) {
+            log_printf("frame_recorder: Error creating %d x %d buffer: %s\n", width, height, SDL_GetError());
+            drop(idx);
+            return -1;
+        }
+        if( DEBUG_LOG ) {
+            log_printf("frame_recorder: buffer %zu: %d x %d\n", idx, width, height);
+        }
+    }
+    return static_cast<int>(idx);
+}
+
+void frame_recorder_t::drop(const size_t buffer_idx) noexcept {
+    std::unique_lock<std::mutex> lock(mtx_);
+    free_buffers_.push_back(buffer_idx);
+    ++frames_dropped_;
+}
+
+void frame_recorder_t::enqueue(const size_t buffer_idx, const std::string& fname, const uint64_t frame_no) noexcept {
+    if( workers_.empty() ) {
+        // first frame, workers_ is only modified by the rendering thread
+        for(size_t i=0; i<worker_count_; ++i) {
+            workers_.emplace_back(&frame_recorder_t::worker_main, this);
+        }
+    }
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        queue_.push_back( job_t { buffer_idx, fname, frame_no } );
+        queue_depth_max_ = std::max<size_t>(queue_depth_max_, ++queue_depth_);
+    }
+    cv_queue_.notify_one();
+}
+
+bool frame_recorder_t::record(SDL_Renderer* rend, const int width, const int height, const std::string& fname) noexcept {
+    const uint64_t frame_no = frames_submitted_++;
+    const int idx = acquire(width, height);
+    if( 0 > idx ) {
+        return false;
+    }
+    SDL_Surface* s = buffers_[idx];
+    if( 0 != SDL_RenderReadPixels(rend, NULL, SDL_PIXELFORMAT_ARGB8888, s->pixels, s->pitch) ) {
+        log_printf("frame_recorder: Error reading back frame %" PRIu64 ": %s\n", frame_no, SDL_GetError());
+        drop(idx);
+        return false;
+    }
+    enqueue(idx, fname, frame_no);
+    return true;
+}
+
+bool frame_recorder_t::record(SDL_Surface* surface, const std::string& fname) noexcept {
+    const uint64_t frame_no = frames_submitted_++;
+    const int idx = acquire(surface->w, surface->h);
+    if( 0 > idx ) {
+        return false;
+    }
+    SDL_Surface* s = buffers_[idx];
+    if( 0 != SDL_ConvertPixels(surface->w, surface->h, surface->format->format, surface->pixels, surface->pitch,
+                               SDL_PIXELFORMAT_ARGB8888, s->pixels, s->pitch) )
+    {
+        log_printf("frame_recorder: Error converting frame %" PRIu64 ": %s\n", frame_no, SDL_GetError());
+        drop(idx);
+        return false;
+    }
+    enqueue(idx, fname, frame_no);
+    return true;
+}
+
+std::string frame_recorder_t::toString() const noexcept {
+    return "recorder["+writer_->toString()+", policy "+to_string(policy_)+", workers "+std::to_string(worker_count_)+
+           ", queue "+std::to_string(queue_depth())+"/"+std::to_string(buffers_.size())+
+           " (max "+std::to_string(queue_depth_max_)+"), written "+std::to_string(frames_written())+
+           ", dropped "+std::to_string(frames_dropped())+", failed "+std::to_string(frames_failed())+"]";
+}
+
+//
+// render_capture_t
+//
+
+void render_capture_t::destroy_targets() noexcept {
+    for(SDL_Texture*& t : targets_) {
+        if( nullptr != t ) {
+            SDL_DestroyTexture(t);
+            t = nullptr;
+        }
+    }
+    width_ = 0;
+    height_ = 0;
+    pending_ = false;
+}
+
+void render_capture_t::reset() noexcept {
+    if( pending_ ) {
+        log_printf("render_capture: Dropped pending frame '%s', render targets reset\n", pending_fname_.c_str());
+    }
+    destroy_targets();
+}
+
+void render_capture_t::flush(SDL_Renderer* rend, frame_recorder_t& recorder) noexcept {
+    if( pending_ ) {
+        SDL_Texture* const old_target = SDL_GetRenderTarget(rend);
+        SDL_SetRenderTarget(rend, targets_[current_ ^ 1]);
+        recorder.record(rend, width_, height_, pending_fname_);
+        SDL_SetRenderTarget(rend, old_target);
+        pending_ = false;
+    }
+}
+
+bool render_capture_t::begin(SDL_Renderer* rend, const int width, const int height, frame_recorder_t& recorder) noexcept {
+    if( SDL_TRUE != SDL_RenderTargetSupported(rend) ) {
+        return false;
+    }
+    if( width != width_ || height != height_ ) {
+        flush(rend, recorder);
+        destroy_targets();
+        for(SDL_Texture*& t : targets_) {
+            t = SDL_CreateTexture(rend, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+            if( nullptr == t ) {
+                log_printf("render_capture: Error creating %d x %d target: %s\n", width, height, SDL_GetError());
+                destroy_targets();
+                return false;
+            }
+            SDL_SetTextureBlendMode(t, SDL_BLENDMODE_NONE);
+        }
+        width_ = width;
+        height_ = height;
+        current_ = 0;
+    }
+    // previous frame has been completed while presenting, read it back before issuing the current frame
+    flush(rend, recorder);
+    SDL_SetRenderTarget(rend, targets_[current_]);
+    return true;
+}
+
+void render_capture_t::end(SDL_Renderer* rend, const std::string& fname) noexcept {
+    SDL_SetRenderTarget(rend, nullptr);
+    SDL_RenderCopy(rend, targets_[current_], NULL, NULL);
+    pending_fname_ = fname;
+    pending_ = true;
+    current_ ^= 1;
+}